@@ -0,0 +1,23 @@
+#include "Base64.h"
+
+#include <stdint.h>
+
+std::string base64_encode(std::string_view data) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string res;
+    res.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = (uint8_t)data[i] << 16;
+        if (i + 1 < data.size())
+            chunk |= (uint8_t)data[i + 1] << 8;
+        if (i + 2 < data.size())
+            chunk |= (uint8_t)data[i + 2];
+
+        res += digits[(chunk >> 18) & 63];
+        res += digits[(chunk >> 12) & 63];
+        res += i + 1 < data.size() ? digits[(chunk >> 6) & 63] : '=';
+        res += i + 2 < data.size() ? digits[chunk & 63] : '=';
+    }
+    return res;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Standard base64 with padding, for binary results inside a json line or data embedded in a page
+std::string base64_encode(std::string_view data);
@@ -0,0 +1,184 @@
+#include "Batch.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Hypergraph.h"
+
+void run_batch(FILE* in, FILE* out, size_t workers, const BatchFunction& process) {
+    workers = std::max<size_t>(workers, 1);
+    // Lines read but not yet written, bounded so a fast producer does not fill memory
+    auto max_in_flight = workers * 4;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<size_t, std::string>> pending;
+    std::map<size_t, std::string> finished;
+    size_t read_count = 0;
+    size_t written_count = 0;
+    bool done_reading = false;
+
+    auto worker_main = [&]() {
+        while (true) {
+            std::pair<size_t, std::string> job;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&]() { return !pending.empty() || done_reading; });
+                if (pending.empty())
+                    return;
+                job = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            std::string result;
+            try {
+                result = process(job.second);
+            } catch (const std::exception& ex) {
+                result = nlohmann::json{ { "error", ex.what() } }.dump();
+            }
+
+            // Whoever finishes the next line in order writes it and every line after it that is ready
+            std::lock_guard lock(mutex);
+            finished.emplace(job.first, std::move(result));
+            bool wrote = false;
+            for (auto it = finished.begin(); it != finished.end() && it->first == written_count; it = finished.erase(it)) {
+                fwrite(it->second.data(), 1, it->second.size(), out);
+                fputc('\n', out);
+                written_count++;
+                wrote = true;
+            }
+            if (wrote) {
+                fflush(out);
+                changed.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; i++)
+        threads.emplace_back(worker_main);
+
+    char* line = nullptr;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, in)) >= 0) {
+        std::string_view text(line, length);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+            text.remove_suffix(1);
+        if (text.find_first_not_of(" \t") == std::string_view::npos)
+            continue;
+
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&]() { return read_count - written_count < max_in_flight; });
+        pending.emplace_back(read_count++, std::string(text));
+        changed.notify_all();
+    }
+    free(line);
+
+    {
+        std::lock_guard lock(mutex);
+        done_reading = true;
+    }
+    changed.notify_all();
+
+    for (auto& t : threads)
+        t.join();
+}
+
+void serve_batch(const std::string& path, size_t workers, const BatchFunction& process) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        hypergraph_error("socket path '%s' is too long", path.c_str());
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    // A client that disconnects early must not end the server
+    signal(SIGPIPE, SIG_IGN);
+
+    // Only a socket left behind by an earlier run is removed, never any other file
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        hypergraph_error("could not create socket: %s", strerror(errno));
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        int error = errno;
+        close(fd);
+        hypergraph_error("could not listen on '%s': %s", path.c_str(), strerror(error));
+    }
+
+    // Connections being served, shared with their threads which may outlive this function when it throws
+    struct Connections {
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t active = 0;
+    };
+    auto connections = std::make_shared<Connections>();
+    auto max_connections = std::max<size_t>(workers, 1);
+
+    while (true) {
+        // Further clients wait in the listen backlog until a connection ends
+        {
+            std::unique_lock lock(connections->mutex);
+            connections->finished.wait(lock, [&]() { return connections->active < max_connections; });
+        }
+
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            int error = errno;
+            close(fd);
+            hypergraph_error("could not accept a connection on '%s': %s", path.c_str(), strerror(error));
+        }
+
+        {
+            std::lock_guard lock(connections->mutex);
+            connections->active++;
+        }
+
+        std::thread([client, workers, process, connections]() {
+            FILE* in = fdopen(client, "r");
+            int out_fd = dup(client);
+            FILE* out = out_fd >= 0 ? fdopen(out_fd, "w") : nullptr;
+            if (in && out)
+                run_batch(in, out, workers, process);
+
+            if (out)
+                fclose(out);
+            else if (out_fd >= 0)
+                close(out_fd);
+            if (in)
+                fclose(in);
+            else
+                close(client);
+
+            std::lock_guard lock(connections->mutex);
+            connections->active--;
+            connections->finished.notify_one();
+        }).detach();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <functional>
+#include <string>
+
+// Turns one input document into one line of output, without the newline
+using BatchFunction = std::function<std::string(const std::string& line)>;
+
+// Runs process on every line of in on workers threads and writes the results to out in the order of the lines, each
+// followed by a newline. Blank lines are skipped. A line that process throws on gives {"error": "..."} instead.
+// Lines are taken as soon as they arrive and every result is flushed as soon as the ones before it are, so a client
+// can wait for each result before it sends the next line. Returns at the end of in once every result is written.
+void run_batch(FILE* in, FILE* out, size_t workers, const BatchFunction& process);
+
+// Listens on a Unix domain socket at path and runs run_batch on every connection, each on its own threads.
+// At most workers connections are served at once, further clients wait until one of them ends.
+// An existing socket at path is replaced. Only returns by throwing when the socket can not be set up.
+void serve_batch(const std::string& path, size_t workers, const BatchFunction& process);
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <bit>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Binary hypergraph format
+//
+// A file is the following sections back to back, every one starting on an 8 byte boundary and all values little endian.
+//
+//   header          BinaryHeader
+//   edge_offsets    uint64[edge_count + 1], the members of edge e are edge_vertices[edge_offsets[e]..edge_offsets[e + 1]]
+//   edge_vertices   uint64[incidence_count], vertex indexes
+//   positions       float64[2 * vertex_count] as x, y pairs, only present when flags has BINARY_HAS_POSITIONS
+//   attributes      BinaryAttribute[attribute_count]
+//   strings         char[string_table_size], NUL terminated strings referenced by their byte offset
+//
+// Attributes hold the scalar options of the json format, a global option like "vertex-fill" or a per element option
+// like "fill" on vertex 3. Keys and string values are offsets into the string table. Whole numbers keep their json type
+// as signed or unsigned integers so they read back exactly, version 1 files only have the first three types.
+// The section sizes follow from the counts in the header so the sections can be found and checked without copying
+// the file once it is mapped, reading them into a Hypergraph copies them.
+
+static_assert(std::endian::native == std::endian::little, "the binary format is only implemented for little endian hosts");
+
+static constexpr char binary_magic[8] = { 'H', 'G', 'R', 'A', 'P', 'H', 'B', '\n' };
+static constexpr uint32_t binary_version = 2;
+
+enum BinaryFlags : uint32_t {
+    BINARY_HAS_POSITIONS = 1,
+};
+
+enum BinaryScope : uint8_t {
+    BINARY_GLOBAL = 0,
+    BINARY_VERTEX = 1,
+    BINARY_EDGE = 2,
+};
+
+enum BinaryType : uint8_t {
+    BINARY_NUMBER = 0,
+    BINARY_STRING = 1,
+    BINARY_BOOLEAN = 2,
+    BINARY_INTEGER = 3,
+    BINARY_UNSIGNED = 4,
+};
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t incidence_count;
+    uint64_t attribute_count;
+    uint64_t string_table_size;
+};
+
+struct BinaryAttribute {
+    uint8_t scope;
+    uint8_t type;
+    uint8_t reserved[6];
+    uint64_t key;
+    // Vertex or edge index, 0 for globals
+    uint64_t index;
+    // float64 bits for numbers, string table offset for strings, 0 or 1 for booleans, int64 or uint64 bits for integers
+    uint64_t value;
+
+    double number() const { return std::bit_cast<double>(value); }
+};
+
+static_assert(sizeof(BinaryHeader) == 56);
+static_assert(sizeof(BinaryAttribute) == 32);
+
+// Read only view of a whole file, mapped when it is a regular file and read into memory otherwise (e.g. a pipe)
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (mapped)
+            munmap((void*)bytes, length);
+    }
+
+    // Reads the whole of file from its start, returns false if it could not be read
+    bool open(FILE* file) {
+        struct stat st;
+        if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            auto res = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+            if (res != MAP_FAILED) {
+                madvise(res, st.st_size, MADV_SEQUENTIAL);
+                bytes = (const char*)res;
+                length = st.st_size;
+                mapped = true;
+                return true;
+            }
+        }
+
+        // Pipes can not be mapped, read them through stdio so bytes already buffered by is_binary_input are kept.
+        // The buffer is uint64 storage to keep the sections 8 byte aligned.
+        size_t used = 0;
+        while (true) {
+            if (used + 65536 > buffer.size() * 8)
+                buffer.resize(std::max<size_t>(buffer.size() * 2, 65536 / 8));
+            auto n = fread((char*)buffer.data() + used, 1, buffer.size() * 8 - used, file);
+            used += n;
+            if (n == 0)
+                break;
+        }
+
+        bytes = (const char*)buffer.data();
+        length = used;
+        return !ferror(file);
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+  private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<uint64_t> buffer;
+};
+
+// True if the next byte of file starts the binary format, json documents can never start with the magic
+inline bool is_binary_input(FILE* file) {
+    int c = getc(file);
+    if (c == EOF)
+        return false;
+    ungetc(c, file);
+    return c == binary_magic[0];
+}
+
+// Sections of a binary hypergraph, pointing into memory owned by someone else
+struct BinaryHypergraph {
+    const BinaryHeader* header = nullptr;
+    const uint64_t* edge_offsets = nullptr;
+    const uint64_t* edge_vertices = nullptr;
+    const double* positions = nullptr;
+    const BinaryAttribute* attributes = nullptr;
+    const char* strings = nullptr;
+
+    size_t vertex_count() const { return header->vertex_count; }
+    size_t edge_count() const { return header->edge_count; }
+    size_t attribute_count() const { return header->attribute_count; }
+
+    const char* string(uint64_t offset) const { return strings + offset; }
+
+    // Value of an attribute in the same form the json input would have had
+    nlohmann::json value(const BinaryAttribute& a) const {
+        switch (a.type) {
+        case BINARY_NUMBER:
+            return a.number();
+        case BINARY_STRING:
+            return string(a.value);
+        case BINARY_INTEGER:
+            return std::bit_cast<int64_t>(a.value);
+        case BINARY_UNSIGNED:
+            return a.value;
+        default:
+            return a.value != 0;
+        }
+    }
+
+    // Points the sections into data and checks that they are consistent, returns an error message or nullptr
+    const char* load(const char* data, size_t size) {
+        if (size < sizeof(BinaryHeader) || memcmp(data, binary_magic, sizeof(binary_magic)) != 0)
+            return "not a binary hypergraph file";
+
+        header = (const BinaryHeader*)data;
+        if (header->version != 1 && header->version != binary_version)
+            return "unsupported binary hypergraph version";
+
+        // Every count is checked against the file size before it is multiplied so that the offsets cannot overflow
+        size_t offset = sizeof(BinaryHeader);
+        auto section = [&](uint64_t count, size_t element_size) -> const char* {
+            if (offset > size || count > (size - offset) / element_size)
+                return nullptr;
+            auto res = data + offset;
+            offset += (count * element_size + 7) & ~(size_t)7;
+            return res;
+        };
+
+        bool has_positions = header->flags & BINARY_HAS_POSITIONS;
+
+        if (header->edge_count >= size)
+            return "truncated binary hypergraph file";
+
+        edge_offsets = (const uint64_t*)section(header->edge_count + 1, sizeof(uint64_t));
+        edge_vertices = (const uint64_t*)section(header->incidence_count, sizeof(uint64_t));
+        positions = has_positions && header->vertex_count < size ? (const double*)section(header->vertex_count * 2, sizeof(double)) : nullptr;
+        attributes = (const BinaryAttribute*)section(header->attribute_count, sizeof(BinaryAttribute));
+        strings = section(header->string_table_size, 1);
+
+        if (!edge_offsets || !edge_vertices || (has_positions && !positions) || !attributes || !strings)
+            return "truncated binary hypergraph file";
+
+        if (edge_offsets[0] != 0 || edge_offsets[header->edge_count] != header->incidence_count)
+            return "invalid edge offsets";
+        for (size_t e = 0; e < header->edge_count; e++) {
+            if (edge_offsets[e] > edge_offsets[e + 1])
+                return "invalid edge offsets";
+        }
+
+        for (size_t i = 0; i < header->incidence_count; i++) {
+            if (edge_vertices[i] >= header->vertex_count)
+                return "edge vertex index out of range";
+        }
+
+        if (header->string_table_size > 0 && strings[header->string_table_size - 1] != '\0')
+            return "string table is not terminated";
+
+        for (size_t i = 0; i < header->attribute_count; i++) {
+            auto& a = attributes[i];
+            if (a.key >= header->string_table_size || (a.type == BINARY_STRING && a.value >= header->string_table_size))
+                return "attribute string out of range";
+            if (a.type > BINARY_UNSIGNED || (header->version == 1 && a.type > BINARY_BOOLEAN))
+                return "invalid attribute type";
+            if ((a.scope == BINARY_VERTEX && a.index >= header->vertex_count) || (a.scope == BINARY_EDGE && a.index >= header->edge_count) || a.scope > BINARY_EDGE)
+                return "attribute index out of range";
+        }
+
+        return nullptr;
+    }
+};
+
+// Collects a hypergraph and writes it in the binary format
+struct BinaryWriter {
+    size_t vertex_count = 0;
+
+    std::vector<uint64_t> edge_offsets = { 0 };
+    std::vector<uint64_t> edge_vertices;
+    std::vector<double> positions;
+    std::vector<BinaryAttribute> attributes;
+
+    std::string strings;
+    std::unordered_map<std::string, uint64_t> interned;
+
+    template <typename Vertices>
+    void add_edge(const Vertices& vertices) {
+        for (auto v : vertices)
+            edge_vertices.push_back(v);
+        edge_offsets.push_back(edge_vertices.size());
+    }
+
+    uint64_t intern(std::string_view str) {
+        auto it = interned.find(std::string(str));
+        if (it != interned.end())
+            return it->second;
+
+        auto offset = strings.size();
+        strings.append(str);
+        strings.push_back('\0');
+        interned.emplace(str, offset);
+        return offset;
+    }
+
+    // Stores a scalar json value, other values have no representation in the format and are dropped
+    void add_attribute(BinaryScope scope, uint64_t index, std::string_view key, const nlohmann::json& value) {
+        BinaryAttribute a = {};
+        a.scope = scope;
+        a.index = index;
+
+        if (value.is_number_unsigned()) {
+            a.type = BINARY_UNSIGNED;
+            a.value = value.get<uint64_t>();
+        } else if (value.is_number_integer()) {
+            a.type = BINARY_INTEGER;
+            a.value = std::bit_cast<uint64_t>(value.get<int64_t>());
+        } else if (value.is_number()) {
+            a.type = BINARY_NUMBER;
+            a.value = std::bit_cast<uint64_t>(value.get<double>());
+        } else if (value.is_string()) {
+            a.type = BINARY_STRING;
+            a.value = intern(value.get_ref<const std::string&>());
+        } else if (value.is_boolean()) {
+            a.type = BINARY_BOOLEAN;
+            a.value = value.get<bool>();
+        } else {
+            return;
+        }
+
+        a.key = intern(key);
+        attributes.push_back(a);
+    }
+
+    // Number of bytes write produces
+    size_t file_size() const {
+        auto padded = [](size_t size) { return (size + 7) & ~(size_t)7; };
+        return padded(sizeof(BinaryHeader)) + padded(edge_offsets.size() * sizeof(uint64_t)) + padded(edge_vertices.size() * sizeof(uint64_t)) +
+               padded(positions.size() * sizeof(double)) + padded(attributes.size() * sizeof(BinaryAttribute)) + padded(strings.size());
+    }
+
+    bool write(FILE* file) const {
+        BinaryHeader header = {};
+        memcpy(header.magic, binary_magic, sizeof(binary_magic));
+        header.version = binary_version;
+        header.flags = positions.empty() ? 0u : (uint32_t)BINARY_HAS_POSITIONS;
+        header.vertex_count = vertex_count;
+        header.edge_count = edge_offsets.size() - 1;
+        header.incidence_count = edge_vertices.size();
+        header.attribute_count = attributes.size();
+        header.string_table_size = strings.size();
+
+        static const char padding[8] = {};
+        bool ok = true;
+        auto section = [&](const void* data, size_t size) {
+            ok = ok && fwrite(data, 1, size, file) == size;
+            ok = ok && fwrite(padding, 1, (8 - size % 8) % 8, file) == (8 - size % 8) % 8;
+        };
+
+        section(&header, sizeof(header));
+        section(edge_offsets.data(), edge_offsets.size() * sizeof(uint64_t));
+        section(edge_vertices.data(), edge_vertices.size() * sizeof(uint64_t));
+        if (!positions.empty())
+            section(positions.data(), positions.size() * sizeof(double));
+        section(attributes.data(), attributes.size() * sizeof(BinaryAttribute));
+        section(strings.data(), strings.size());
+
+        return ok && fflush(file) == 0;
+    }
+};
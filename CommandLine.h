@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <cmath>
+#include <exception>
+#include <string>
+
+#include "Hypergraph.h"
+
+// Checked values of command line flags, anything but a whole number or a finite number is an error naming the flag
+
+inline size_t parse_count_flag(const std::string& flag, const std::string& value) {
+    size_t end = 0;
+    unsigned long long res = 0;
+    try {
+        // stoull would wrap negative values around
+        if (!value.empty() && value[0] != '-')
+            res = std::stoull(value, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size())
+        hypergraph_error("%s expects a whole number, got '%s'", flag.c_str(), value.c_str());
+    return (size_t)res;
+}
+
+inline double parse_number_flag(const std::string& flag, const std::string& value) {
+    size_t end = 0;
+    double res = 0;
+    try {
+        res = std::stod(value, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size() || !std::isfinite(res))
+        hypergraph_error("%s expects a number, got '%s'", flag.c_str(), value.c_str());
+    return res;
+}
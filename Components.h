@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "Hypergraph.h"
+#include "Vec2f.h"
+
+// Connected components of a hypergraph, numbered in the order of their smallest vertex.
+// Vertices and hyperedges of component c are vertices[vertex_starts[c]..vertex_starts[c + 1]] and likewise for edges,
+// each in increasing order. Hyperedges without vertices belong to no component.
+struct Components {
+    size_t count = 0;
+    std::vector<size_t> component;
+    std::vector<size_t> vertices;
+    std::vector<size_t> vertex_starts;
+    std::vector<size_t> edges;
+    std::vector<size_t> edge_starts;
+
+    size_t vertex_count(size_t c) const { return vertex_starts[c + 1] - vertex_starts[c]; }
+};
+
+// Union-find over the incidence lists with path halving and union by size, near linear in the number of incidences
+inline Components connected_components(const Hypergraph& g) {
+    auto n = g.vertices.size();
+
+    std::vector<size_t> parent(n);
+    std::vector<size_t> size(n, 1);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    auto find = [&](size_t v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+
+    for (auto& e : g.edges) {
+        if (e.vertices.empty())
+            continue;
+        auto root = find(e.vertices[0]);
+        for (size_t i = 1; i < e.vertices.size(); i++) {
+            auto other = find(e.vertices[i]);
+            if (other == root)
+                continue;
+            if (size[other] > size[root])
+                std::swap(root, other);
+            parent[other] = root;
+            size[root] += size[other];
+        }
+    }
+
+    Components res;
+    res.component.assign(n, SIZE_MAX);
+
+    // Visiting vertices in order numbers components by their smallest vertex
+    std::vector<size_t> root_component(n, SIZE_MAX);
+    for (size_t v = 0; v < n; v++) {
+        auto root = find(v);
+        if (root_component[root] == SIZE_MAX)
+            root_component[root] = res.count++;
+        res.component[v] = root_component[root];
+    }
+
+    // Counting sort of the vertices and hyperedges by component
+    auto bucket = [&](auto&& component_of, size_t item_count, std::vector<size_t>& items, std::vector<size_t>& starts) {
+        starts.assign(res.count + 1, 0);
+        for (size_t i = 0; i < item_count; i++) {
+            if (auto c = component_of(i); c != SIZE_MAX)
+                starts[c + 1]++;
+        }
+        std::partial_sum(starts.begin(), starts.end(), starts.begin());
+
+        items.resize(starts.back());
+        auto next = starts;
+        for (size_t i = 0; i < item_count; i++) {
+            if (auto c = component_of(i); c != SIZE_MAX)
+                items[next[c]++] = i;
+        }
+    };
+
+    bucket([&](size_t v) { return res.component[v]; }, n, res.vertices, res.vertex_starts);
+    bucket([&](size_t e) { return g.edges[e].vertices.empty() ? SIZE_MAX : res.component[g.edges[e].vertices[0]]; }, g.edges.size(), res.edges, res.edge_starts);
+
+    return res;
+}
+
+// Shelf packing of rectangles into a roughly square area. Rectangles are placed from the tallest down in rows as wide
+// as the square root of their total area, or the widest rectangle. Returns the lower left corner of every rectangle
+// with gap left between neighbours.
+inline std::vector<Vec2f> pack_rectangles(const std::vector<Vec2f>& sizes, double gap) {
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a].y > sizes[b].y; });
+
+    double area = 0;
+    double widest = 0;
+    for (auto s : sizes) {
+        area += (s.x + gap) * (s.y + gap);
+        widest = std::max(widest, s.x + gap);
+    }
+    auto row_width = std::max(widest, std::sqrt(area));
+
+    std::vector<Vec2f> res(sizes.size());
+    Vec2f cursor = {};
+    double row_height = 0;
+    for (auto i : order) {
+        if (cursor.x > 0 && cursor.x + sizes[i].x + gap > row_width) {
+            cursor = { 0, cursor.y + row_height };
+            row_height = 0;
+        }
+        res[i] = cursor;
+        cursor.x += sizes[i].x + gap;
+        row_height = std::max(row_height, sizes[i].y + gap);
+    }
+    return res;
+}
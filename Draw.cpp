@@ -0,0 +1,1259 @@
+#include "Draw.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#include "Base64.h"
+#include "Raster.h"
+#include "SpatialIndex.h"
+#include "SvgWriter.h"
+#include "Vec2f.h"
+
+DrawOptions DrawOptions::from_json(const nlohmann::json& json) {
+    DrawOptions options;
+
+    if (json.contains("padding-top") && json["padding-top"].is_number())
+        options.padding.top = json["padding-top"].get<double>();
+    if (json.contains("padding-bottom") && json["padding-bottom"].is_number())
+        options.padding.bottom = json["padding-bottom"].get<double>();
+    if (json.contains("padding-left") && json["padding-left"].is_number())
+        options.padding.left = json["padding-left"].get<double>();
+    if (json.contains("padding-right") && json["padding-right"].is_number())
+        options.padding.right = json["padding-right"].get<double>();
+
+    if (json.contains("vertex-radius") && json["vertex-radius"].is_number())
+        options.vertex_radius = json["vertex-radius"].get<double>();
+
+    if (json.contains("edge-draw-radius") && json["edge-draw-radius"].is_number())
+        options.edge_draw_radius = json["edge-draw-radius"].get<double>();
+
+    // vertex-fill, edge-stroke-width, ...
+    auto read_paint = [&](PaintDefaults& paint, const std::string& prefix) {
+        if (json.contains(prefix + "-fill") && json[prefix + "-fill"].is_string())
+            paint.fill = json[prefix + "-fill"].get<std::string>();
+
+        if (json.contains(prefix + "-fill-opacity") && json[prefix + "-fill-opacity"].is_number())
+            paint.fill_opacity = json[prefix + "-fill-opacity"].get<double>();
+
+        if (json.contains(prefix + "-stroke") && json[prefix + "-stroke"].is_string())
+            paint.stroke = json[prefix + "-stroke"].get<std::string>();
+
+        if (json.contains(prefix + "-stroke-opacity") && json[prefix + "-stroke-opacity"].is_number())
+            paint.stroke_opacity = json[prefix + "-stroke-opacity"].get<double>();
+
+        if (json.contains(prefix + "-stroke-width") && json[prefix + "-stroke-width"].is_number())
+            paint.stroke_width = json[prefix + "-stroke-width"].get<double>();
+    };
+
+    read_paint(options.vertex, "vertex");
+    read_paint(options.edge, "edge");
+
+    if (json.contains("edge-convex-hull") && json["edge-convex-hull"].is_boolean())
+        options.edge_hull = json["edge-convex-hull"].get<bool>();
+
+    if (json.contains("raster-width") && json["raster-width"].is_number_unsigned())
+        options.raster_width = json["raster-width"].get<size_t>();
+
+    if (json.contains("raster-height") && json["raster-height"].is_number_unsigned())
+        options.raster_height = json["raster-height"].get<size_t>();
+
+    if (json.contains("tile-size") && json["tile-size"].is_number_unsigned())
+        options.tile_size = json["tile-size"].get<size_t>();
+
+    if (json.contains("tile-max-zoom") && json["tile-max-zoom"].is_number_unsigned())
+        options.tile_max_zoom = json["tile-max-zoom"].get<size_t>();
+
+    if (json.contains("coordinate-precision") && json["coordinate-precision"].is_number_integer())
+        options.precision = json["coordinate-precision"].get<int>();
+
+    if (options.precision < 0 || options.precision > 15)
+        hypergraph_error("coordinate-precision must be between 0 and 15");
+
+    return options;
+}
+
+// Resolved paint of a shape, the strings point into the options or the element they came from
+struct ShapeStyle {
+    std::string_view fill;
+    double fill_opacity;
+    std::string_view stroke;
+    double stroke_opacity;
+    double stroke_width;
+
+    bool operator==(const ShapeStyle&) const = default;
+
+    struct Hash {
+        size_t operator()(const ShapeStyle& s) const {
+            size_t h = std::hash<std::string_view>()(s.fill);
+            h = h * 31 + std::hash<double>()(s.fill_opacity);
+            h = h * 31 + std::hash<std::string_view>()(s.stroke);
+            h = h * 31 + std::hash<double>()(s.stroke_opacity);
+            h = h * 31 + std::hash<double>()(s.stroke_width);
+            return h;
+        }
+    };
+};
+
+// Mean position of the vertices of e, labels are placed there
+static Vec2f edge_mean(const Hypergraph& g, const Hyperedge& e) {
+    Vec2f sum = {};
+    for (auto v : e.vertices)
+        sum += g.vertices[v].pos;
+    return sum / (double)e.vertices.size();
+}
+
+// Convex hull of verts in counterclockwise order without collinear points, by Andrew's monotone chain in O(n log n)
+static std::vector<size_t> convex_hull(const Hypergraph& g, std::vector<size_t> verts) {
+    auto pos = [&](size_t v) { return g.vertices[v].pos; };
+
+    std::sort(verts.begin(), verts.end(), [&](size_t a, size_t b) {
+        auto pa = pos(a);
+        auto pb = pos(b);
+        return pa.x < pb.x || (pa.x == pb.x && pa.y < pb.y);
+    });
+
+    // Positive when o, a, b turn counterclockwise
+    auto cross = [&](size_t o, size_t a, size_t b) {
+        auto oa = pos(a) - pos(o);
+        auto ob = pos(b) - pos(o);
+        return oa.x * ob.y - oa.y * ob.x;
+    };
+
+    // Lower chain left to right, then upper chain right to left
+    std::vector<size_t> hull(2 * verts.size());
+    size_t k = 0;
+    for (size_t i = 0; i < verts.size(); i++) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], verts[i]) <= 0)
+            k--;
+        hull[k++] = verts[i];
+    }
+    for (size_t i = verts.size() - 1, lower = k + 1; i > 0; i--) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], verts[i - 1]) <= 0)
+            k--;
+        hull[k++] = verts[i - 1];
+    }
+
+    // The last point is the first one again
+    hull.resize(k - 1);
+    return hull;
+}
+
+std::vector<size_t> edge_outline(const Hypergraph& g, const Hyperedge& e, bool hull) {
+    auto edge_verts = hull && e.vertices.size() > 3 ? convex_hull(g, e.vertices) : e.vertices;
+
+    auto mean = edge_mean(g, e);
+
+    // Sort the vertices in clockwise order, on angles computed once per vertex
+    std::vector<std::pair<double, size_t>> keys;
+    keys.reserve(edge_verts.size());
+    for (auto v : edge_verts) {
+        auto p = g.vertices[v].pos - mean;
+        keys.emplace_back(std::atan2(p.y, p.x), v);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t i = 0; i < keys.size(); i++)
+        edge_verts[i] = keys[i].second;
+
+    // Consecutive vertices on the same point would give a side of the outline without a direction
+    auto same = [&](size_t a, size_t b) { return g.vertices[a].pos.x == g.vertices[b].pos.x && g.vertices[a].pos.y == g.vertices[b].pos.y; };
+    edge_verts.erase(std::unique(edge_verts.begin(), edge_verts.end(), same), edge_verts.end());
+    while (edge_verts.size() > 1 && same(edge_verts.front(), edge_verts.back()))
+        edge_verts.pop_back();
+
+    return edge_verts;
+}
+
+static void style_class(SvgWriter& w, uint32_t style) { w << "class=\"s" << (int)style << "\" />\n"; }
+
+static double edge_radius(const Hypergraph& g, const DrawOptions& options, size_t e) {
+    return g.edge_styles.has(e, StyleColumns::RADIUS) ? g.edge_styles.radius[e] : options.edge_draw_radius;
+}
+
+static bool edge_hull(const Hypergraph& g, const DrawOptions& options, size_t e) {
+    return g.edge_styles.has(e, StyleColumns::CONVEX_HULL) ? g.edge_styles.convex_hull[e] != 0 : options.edge_hull;
+}
+
+static double vertex_radius(const Hypergraph& g, const DrawOptions& options, size_t v) {
+    return g.vertex_styles.has(v, StyleColumns::RADIUS) ? g.vertex_styles.radius[v] : options.vertex_radius;
+}
+
+// Emits the outline of an edge of at least 2 vertices, the sides run parallel to the lines between consecutive
+// vertices at radius and are joined by arcs around the vertices. Path is an SvgPath or a RasterPath.
+template <typename Path>
+static void edge_path(const Hypergraph& g, const std::vector<size_t>& edge_verts, double radius, Path& path) {
+    auto edge_line = [&](Vec2f a, Vec2f b, Vec2f c, bool first) {
+        auto offset_p1 = (a - b).rot90().normalized() * radius;
+        auto offset_p2 = (b - c).rot90().normalized() * radius;
+
+        auto p1 = b + offset_p1;
+        auto p2 = b + offset_p2;
+
+        auto o1 = a + offset_p1;
+        auto o2 = c + offset_p2;
+
+        auto a1 = std::atan2(offset_p1.y, offset_p1.x);
+        auto a2 = std::atan2(offset_p2.y, offset_p2.x);
+
+        auto ang = a1 - a2;
+
+        if (1.0001 * ang > M_PI)
+            ang -= 2 * M_PI;
+        else if (0.99999 * ang < -M_PI)
+            ang += 2 * M_PI;
+
+        if (ang > 0) {
+            double a1 = o1.y - p1.y;
+            double b1 = p1.x - o1.x;
+            double c1 = a1 * (p1.x) + b1 * (p1.y);
+
+            double a2 = o2.y - p2.y;
+            double b2 = p2.x - o2.x;
+            double c2 = a2 * (p2.x) + b2 * (p2.y);
+
+            auto determinant = a1 * b2 - a2 * b1;
+
+            Vec2f intersect{ (b2 * c1 - b1 * c2) / determinant, (a1 * c2 - a2 * c1) / determinant };
+
+            if (determinant < 0.0001) {
+                intersect = (p1 + p2) / 2.0f;
+            }
+
+            auto x1 = p1 + (intersect - p1) * 2;
+            auto x2 = p2 + (intersect - p2) * 2;
+
+            if (first) {
+                path.move_to(x2);
+            } else {
+                path.line_to(x1);
+                path.arc_to(radius, radius, 0, 0, x2);
+            }
+
+        } else {
+
+            auto p1_ang = std::atan2((p1 - b).y, (p1 - b).x);
+            auto p2_ang = std::atan2((p2 - b).y, (p2 - b).x);
+
+            int large_arc = p2_ang - p1_ang < M_PI ? 0 : 1;
+
+            if (first) {
+                path.move_to(p2);
+            } else {
+                path.line_to(p1);
+                path.arc_to(radius, radius, large_arc, 1, p2);
+            }
+        }
+    };
+
+    if (edge_verts.size() == 2) {
+        edge_line(g.vertices[edge_verts[0]].pos, g.vertices[edge_verts[1]].pos, g.vertices[edge_verts[0]].pos, true);
+        edge_line(g.vertices[edge_verts[1]].pos, g.vertices[edge_verts[0]].pos, g.vertices[edge_verts[1]].pos, false);
+        edge_line(g.vertices[edge_verts[0]].pos, g.vertices[edge_verts[1]].pos, g.vertices[edge_verts[0]].pos, false);
+    } else if (edge_verts.size() > 2) {
+        auto prevprev = g.vertices[edge_verts[0]].pos;
+        auto prev = g.vertices[edge_verts[1]].pos;
+
+        edge_line(prevprev, prev, g.vertices[edge_verts[2]].pos, true);
+
+        prevprev = prev;
+        prev = g.vertices[edge_verts[2]].pos;
+
+        for (size_t i = 3; i < edge_verts.size(); i++) {
+            auto cur = g.vertices[edge_verts[i]].pos;
+
+            edge_line(prevprev, prev, cur, false);
+            prevprev = prev;
+            prev = cur;
+        }
+        edge_line(prevprev, prev, g.vertices[edge_verts[0]].pos, false);
+        edge_line(prev, g.vertices[edge_verts[0]].pos, g.vertices[edge_verts[1]].pos, false);
+        edge_line(g.vertices[edge_verts[0]].pos, g.vertices[edge_verts[1]].pos, g.vertices[edge_verts[2]].pos, false);
+    }
+}
+
+static void render_edge(const Hypergraph& g, const DrawOptions& options, size_t i, uint32_t style, std::string& out) {
+    SvgWriter w(out, options.precision);
+    SvgPath path{ w };
+
+    auto& e = g.edges[i];
+    auto radius = edge_radius(g, options, i);
+    auto edge_verts = edge_outline(g, e, edge_hull(g, options, i));
+
+    if (edge_verts.size() == 1) {
+        w << "    <circle r=\"" << radius << "\" cx=\"" << Coord{ g.vertices[edge_verts[0]].pos.x } << "\" cy=\"" << Coord{ g.vertices[edge_verts[0]].pos.y } << "\" ";
+        style_class(w, style);
+    } else if (edge_verts.size() >= 2) {
+        w << "    <path d=\"";
+        edge_path(g, edge_verts, radius, path);
+        w << "\" ";
+        style_class(w, style);
+    }
+
+    if (g.edge_styles.has(i, StyleColumns::LABEL)) {
+        auto mean = edge_mean(g, e);
+        w << "<text x=\"" << Coord{ mean.x } << "\" y=\"" << Coord{ mean.y } << "\">" << g.strings.get(g.edge_styles.label[i]) << "</text>\n";
+    }
+}
+
+// Area the drawing covers in user units, the bounds of the vertices grown by the padding
+struct ViewBox {
+    Vec2f min;
+    Vec2f size;
+};
+
+static ViewBox view_box(const Hypergraph& g, const DrawOptions& options) {
+    struct {
+        Vec2f min = { INFINITY, INFINITY };
+        Vec2f max = { -INFINITY, -INFINITY };
+        Vec2f size;
+    } bounds;
+
+    for (auto& v : g.vertices) {
+        if (v.pos.x < bounds.min.x)
+            bounds.min.x = v.pos.x;
+        if (v.pos.x > bounds.max.x)
+            bounds.max.x = v.pos.x;
+        if (v.pos.y < bounds.min.y)
+            bounds.min.y = v.pos.y;
+        if (v.pos.y > bounds.max.y)
+            bounds.max.y = v.pos.y;
+    }
+
+    bounds.size = bounds.max - bounds.min;
+
+    auto& padding = options.padding;
+    return {
+        { bounds.min.x - padding.left, bounds.min.y - padding.top },
+        { bounds.size.x + padding.left + padding.right, bounds.size.y + padding.top + padding.bottom },
+    };
+}
+
+// Resolves the paint of every vertex and edge and gives every distinct combination an index into styles
+static void resolve_styles(const Hypergraph& g, const DrawOptions& options, std::vector<ShapeStyle>& styles, std::vector<uint32_t>& vertex_styles, std::vector<uint32_t>& edge_styles) {
+    std::unordered_map<ShapeStyle, uint32_t, ShapeStyle::Hash> style_ids;
+
+    auto intern = [&](const Style& style, const PaintDefaults& paint) -> uint32_t {
+        ShapeStyle res = {
+            .fill = style.fill ? *style.fill : paint.fill,
+            .fill_opacity = style.fill_opacity.value_or(paint.fill_opacity),
+            .stroke = style.stroke ? *style.stroke : paint.stroke,
+            .stroke_opacity = style.stroke_opacity.value_or(paint.stroke_opacity),
+            .stroke_width = style.stroke_width.value_or(paint.stroke_width),
+        };
+
+        auto [it, inserted] = style_ids.try_emplace(res, styles.size());
+        if (inserted)
+            styles.push_back(res);
+        return it->second;
+    };
+
+    edge_styles.resize(g.edges.size());
+    for (size_t i = 0; i < g.edges.size(); i++)
+        edge_styles[i] = intern(g.edge_style(i), options.edge);
+
+    vertex_styles.resize(g.vertices.size());
+    for (size_t i = 0; i < g.vertices.size(); i++)
+        vertex_styles[i] = intern(g.vertex_style(i), options.vertex);
+}
+
+void draw_svg(const Hypergraph& g, const DrawOptions& options, const std::function<void(std::string_view)>& write, ThreadPool* pool, Stats* stats) {
+    g.validate(true);
+
+    if (options.precision < 0 || options.precision > 15)
+        hypergraph_error("coordinate-precision must be between 0 and 15");
+
+    auto& vertices = g.vertices;
+    auto& edges = g.edges;
+
+    auto box = view_box(g, options);
+
+    // Output is collected in a buffer and written in large blocks
+    std::string out;
+    SvgWriter w(out, options.precision);
+
+    auto flush = [&]() {
+        write(out);
+        out.clear();
+    };
+
+    // Every distinct style is resolved once and written as a CSS class that the shapes reference
+    std::vector<ShapeStyle> styles;
+    std::vector<uint32_t> vertex_styles;
+    std::vector<uint32_t> edge_styles;
+
+    {
+        StatsTimer timer(stats, "styles");
+        resolve_styles(g, options, styles, vertex_styles, edge_styles);
+    }
+
+    if (stats)
+        stats->set("styles", styles.size());
+
+    w << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+    w << "<svg version=\"1.1\" xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"" << Coord{ box.min.x } << " " << Coord{ box.min.y } << " " << Coord{ box.size.x } << " " << Coord{ box.size.y }
+      << "\">\n";
+
+    w << "<style>\n";
+    w << "path,circle{stroke-linecap:round}\n";
+    w << "text{dominant-baseline:middle;text-anchor:middle;font-size:10px}\n";
+    for (size_t i = 0; i < styles.size(); i++) {
+        auto& style = styles[i];
+        w << ".s" << (int)i << "{fill:" << style.fill << ";fill-opacity:" << style.fill_opacity << ";stroke:" << style.stroke << ";stroke-opacity:" << style.stroke_opacity
+          << ";stroke-width:" << style.stroke_width << "}\n";
+    }
+    w << "</style>\n";
+    flush();
+
+    // Edges are rendered in parallel batches into one buffer per chunk of edges, the chunks are written in order so
+    // the output is the same for any number of threads
+    {
+        StatsTimer timer(stats, "edges");
+        constexpr size_t edges_per_chunk = 64;
+
+        std::unique_ptr<ThreadPool> own_pool;
+        if (!pool) {
+            own_pool = std::make_unique<ThreadPool>(options.threads ? options.threads : std::thread::hardware_concurrency());
+            pool = own_pool.get();
+        }
+
+        std::vector<std::string> chunks(pool->thread_count() * 8);
+
+        for (size_t first = 0; first < edges.size(); first += chunks.size() * edges_per_chunk) {
+            auto batch_chunks = std::min(chunks.size(), (edges.size() - first + edges_per_chunk - 1) / edges_per_chunk);
+
+            pool->parallel_for(batch_chunks, 1, [&](size_t begin, size_t end) {
+                for (auto c = begin; c < end; c++) {
+                    chunks[c].clear();
+                    auto chunk_first = first + c * edges_per_chunk;
+                    for (auto i = chunk_first; i < std::min(edges.size(), chunk_first + edges_per_chunk); i++)
+                        render_edge(g, options, i, edge_styles[i], chunks[c]);
+                }
+            });
+
+            flush();
+            for (size_t c = 0; c < batch_chunks; c++)
+                write(chunks[c]);
+        }
+    }
+
+    StatsTimer timer(stats, "vertices");
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto& v = vertices[i];
+
+        w << "    <circle r=\"" << vertex_radius(g, options, i) << "\" cx=\"" << Coord{ v.pos.x } << "\" cy=\"" << Coord{ v.pos.y } << "\" ";
+        style_class(w, vertex_styles[i]);
+
+        if (g.vertex_styles.has(i, StyleColumns::LABEL)) {
+            w << "<text x=\"" << Coord{ v.pos.x } << "\" y=\"" << Coord{ v.pos.y } << "\">" << g.strings.get(g.vertex_styles.label[i]) << "</text>\n";
+        }
+
+        if (out.size() > 1 << 20)
+            flush();
+    }
+
+    w << "</svg>\n";
+    flush();
+}
+
+std::string draw_svg(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool, Stats* stats) {
+    std::string res;
+    draw_svg(g, options, [&](std::string_view str) { res.append(str); }, pool, stats);
+    return res;
+}
+
+// Paint of a resolved style as parsed colors
+struct RasterPaint {
+    Rgba fill;
+    float fill_opacity;
+    Rgba stroke;
+    float stroke_opacity;
+    double stroke_width;
+};
+
+// Colors that can not be parsed are drawn black
+static std::vector<RasterPaint> raster_paints(const std::vector<ShapeStyle>& styles) {
+    std::vector<RasterPaint> paints;
+    for (auto& s : styles) {
+        paints.push_back({
+            .fill = parse_color(s.fill).value_or(Rgba{ 0, 0, 0, 1 }),
+            .fill_opacity = (float)std::clamp(s.fill_opacity, 0.0, 1.0),
+            .stroke = parse_color(s.stroke).value_or(Rgba{ 0, 0, 0, 1 }),
+            .stroke_opacity = (float)std::clamp(s.stroke_opacity, 0.0, 1.0),
+            .stroke_width = s.stroke_width,
+        });
+    }
+    return paints;
+}
+
+// A shape flattened to pixel coordinates and the pixels it may touch
+struct RasterShape {
+    RasterPath path;
+    RasterPath stroke;
+    uint32_t style = 0;
+    long x0 = 0;
+    long y0 = 0;
+    long x1 = 0;
+    long y1 = 0;
+
+    void set_transform(Vec2f offset, double scale) {
+        path.offset = offset;
+        path.scale = scale;
+        stroke.scale = scale;
+    }
+};
+
+static void edge_shape(const Hypergraph& g, const DrawOptions& options, size_t e, const std::vector<size_t>& edge_verts, RasterPath& path) {
+    auto radius = edge_radius(g, options, e);
+    if (edge_verts.size() == 1)
+        path.circle(g.vertices[edge_verts[0]].pos, radius);
+    else
+        edge_path(g, edge_verts, radius, path);
+}
+
+// Builds the stroke of a flattened shape and clips its pixel bounds to an image of width x height
+static void finish_shape(RasterShape& shape, const RasterPaint& paint, double width, double height) {
+    shape.stroke.clear();
+    if (paint.stroke.a * paint.stroke_opacity > 0 && paint.stroke_width > 0)
+        shape.path.stroke(shape.stroke, paint.stroke_width);
+
+    // Strokes reach half their width past the path, one more pixel covers the anti-aliasing
+    auto margin = paint.stroke_width * shape.path.scale / 2 + 1;
+    double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (auto& p : shape.path.points) {
+        min_x = std::min(min_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_x = std::max(max_x, p.x);
+        max_y = std::max(max_y, p.y);
+    }
+    shape.x0 = (long)std::clamp(std::floor(min_x - margin), 0.0, width);
+    shape.y0 = (long)std::clamp(std::floor(min_y - margin), 0.0, height);
+    shape.x1 = (long)std::clamp(std::ceil(max_x + margin), 0.0, width);
+    shape.y1 = (long)std::clamp(std::ceil(max_y + margin), 0.0, height);
+}
+
+// Draws the rows [band_y0, band_y1) of a shape, fill first and stroke on top as in SVG
+static void draw_shape(Rasterizer& r, Image& image, const RasterShape& shape, const RasterPaint& paint, long band_y0, long band_y1) {
+    auto y0 = std::max(shape.y0, band_y0);
+    auto y1 = std::min(shape.y1, band_y1);
+    if (y0 >= y1 || shape.x0 >= shape.x1)
+        return;
+
+    if (paint.fill.a * paint.fill_opacity > 0) {
+        r.begin(shape.x0, y0, shape.x1, y1);
+        shape.path.fill(r);
+        r.fill(image, paint.fill, paint.fill_opacity);
+    }
+
+    if (shape.stroke.subpath_count()) {
+        r.begin(shape.x0, y0, shape.x1, y1);
+        shape.stroke.fill(r);
+        r.fill(image, paint.stroke, paint.stroke_opacity);
+    }
+}
+
+static ThreadPool* use_pool(ThreadPool* pool, std::unique_ptr<ThreadPool>& own_pool, const DrawOptions& options) {
+    if (!pool) {
+        own_pool = std::make_unique<ThreadPool>(options.threads ? options.threads : std::thread::hardware_concurrency());
+        pool = own_pool.get();
+    }
+    return pool;
+}
+
+Image draw_raster(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool, Stats* stats) {
+    g.validate(true);
+
+    auto box = view_box(g, options);
+
+    if (options.raster_width == 0 || options.raster_width > max_raster_size || options.raster_height > max_raster_size)
+        hypergraph_error("raster size must be between 1 and %zu pixels", max_raster_size);
+
+    // Scale to the width, or fit into both dimensions and center when the height is given as well
+    double width = (double)options.raster_width;
+    double scale = box.size.x > 0 ? width / box.size.x : 1;
+    double height = options.raster_height ? (double)options.raster_height : std::max(1.0, std::ceil(box.size.y * scale));
+    if (options.raster_height && box.size.y > 0)
+        scale = std::min(scale, height / box.size.y);
+    if (height > max_raster_size)
+        hypergraph_error("raster height of %.0f pixels is too large, at most %zu are supported", height, max_raster_size);
+
+    Vec2f offset = box.min - Vec2f{ (width / scale - box.size.x) / 2, (height / scale - box.size.y) / 2 };
+
+    Image image((size_t)width, (size_t)height);
+
+    std::vector<ShapeStyle> styles;
+    std::vector<uint32_t> vertex_styles;
+    std::vector<uint32_t> edge_styles;
+    std::vector<RasterPaint> paints;
+
+    {
+        StatsTimer timer(stats, "styles");
+        resolve_styles(g, options, styles, vertex_styles, edge_styles);
+        paints = raster_paints(styles);
+    }
+
+    if (stats)
+        stats->set("styles", styles.size());
+
+    std::unique_ptr<ThreadPool> own_pool;
+    pool = use_pool(pool, own_pool, options);
+
+    // The image is split into bands of rows that are drawn in parallel, every band draws all shapes that reach into it
+    // in order so overlapping shapes composite the same as in the SVG
+    constexpr size_t band_height = 32;
+    auto band_count = (image.height + band_height - 1) / band_height;
+
+    // Shapes are flattened in batches to bound the memory they take
+    constexpr size_t shapes_per_batch = 4096;
+    std::vector<RasterShape> shapes(shapes_per_batch);
+    for (auto& shape : shapes)
+        shape.set_transform(offset, scale);
+
+    auto draw_batch = [&](size_t count) {
+        pool->parallel_for(band_count, 1, [&](size_t begin, size_t end) {
+            // Buffers are kept per thread so they are only allocated once
+            thread_local Rasterizer r;
+            for (auto band = begin; band < end; band++) {
+                auto band_y0 = (long)(band * band_height);
+                auto band_y1 = std::min((long)image.height, band_y0 + (long)band_height);
+                for (size_t i = 0; i < count; i++)
+                    draw_shape(r, image, shapes[i], paints[shapes[i].style], band_y0, band_y1);
+            }
+        });
+    };
+
+    {
+        StatsTimer timer(stats, "edges");
+        for (size_t first = 0; first < g.edges.size(); first += shapes_per_batch) {
+            auto count = std::min(shapes_per_batch, g.edges.size() - first);
+
+            pool->parallel_for(count, 64, [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto e = first + i;
+                    auto& shape = shapes[i];
+                    shape.path.clear();
+                    shape.style = edge_styles[e];
+                    edge_shape(g, options, e, edge_outline(g, g.edges[e], edge_hull(g, options, e)), shape.path);
+                    finish_shape(shape, paints[shape.style], width, height);
+                }
+            });
+
+            draw_batch(count);
+        }
+    }
+
+    {
+        StatsTimer timer(stats, "vertices");
+        for (size_t first = 0; first < g.vertices.size(); first += shapes_per_batch) {
+            auto count = std::min(shapes_per_batch, g.vertices.size() - first);
+
+            pool->parallel_for(count, 256, [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto& shape = shapes[i];
+                    shape.path.clear();
+                    shape.style = vertex_styles[first + i];
+                    shape.path.circle(g.vertices[first + i].pos, vertex_radius(g, options, first + i));
+                    finish_shape(shape, paints[shape.style], width, height);
+                }
+            });
+
+            draw_batch(count);
+        }
+    }
+
+    return image;
+}
+
+TileLevels tile_levels(const Hypergraph& g, const DrawOptions& options) {
+    auto box = view_box(g, options);
+
+    TileLevels levels;
+    levels.origin = box.min;
+    levels.size = std::max({ box.size.x, box.size.y, 1e-9 });
+
+    // By default the deepest level shows the drawing at one pixel per unit
+    auto native = std::ceil(std::log2(levels.size / (double)options.tile_size));
+    levels.max_zoom = options.tile_max_zoom.value_or((size_t)std::clamp(native, 0.0, (double)max_tile_zoom));
+    if (levels.max_zoom > max_tile_zoom)
+        hypergraph_error("tile zoom levels deeper than %zu are not supported", max_tile_zoom);
+    return levels;
+}
+
+// Shapes smaller than this many pixels at a zoom level are left out of its tiles
+static constexpr double tile_cull_pixels = 0.5;
+// Hyperedges smaller than this are drawn as the polygon through their vertices without rounded outlines
+static constexpr double tile_simplify_pixels = 4;
+
+void draw_tiles(const Hypergraph& g, const DrawOptions& options, const std::function<void(const Tile&)>& write, ThreadPool* pool, Stats* stats) {
+    g.validate(true);
+
+    if (options.tile_size == 0 || options.tile_size > max_raster_size)
+        hypergraph_error("tile size must be between 1 and %zu pixels", max_raster_size);
+
+    auto levels = tile_levels(g, options);
+
+    std::vector<ShapeStyle> styles;
+    std::vector<uint32_t> vertex_styles;
+    std::vector<uint32_t> edge_styles;
+    std::vector<RasterPaint> paints;
+
+    {
+        StatsTimer timer(stats, "styles");
+        resolve_styles(g, options, styles, vertex_styles, edge_styles);
+        paints = raster_paints(styles);
+    }
+
+    std::unique_ptr<ThreadPool> own_pool;
+    pool = use_pool(pool, own_pool, options);
+
+    // Elements are the hyperedges followed by the vertices, which is also the order they are drawn in
+    auto edge_count = g.edges.size();
+    std::vector<Box> boxes(edge_count + g.vertices.size());
+    std::vector<std::vector<size_t>> outlines(edge_count);
+    SpatialIndex index;
+
+    {
+        StatsTimer timer(stats, "index");
+        pool->parallel_for(edge_count, 64, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++) {
+                outlines[i] = edge_outline(g, g.edges[i], edge_hull(g, options, i));
+
+                // The outline never leaves the circles of the edge radius around its vertices
+                auto reach = edge_radius(g, options, i) + paints[edge_styles[i]].stroke_width / 2;
+                for (auto v : outlines[i]) {
+                    auto p = g.vertices[v].pos;
+                    boxes[i].add({ p - Vec2f{ reach, reach }, p + Vec2f{ reach, reach } });
+                }
+            }
+        });
+
+        for (size_t i = 0; i < g.vertices.size(); i++) {
+            auto& v = g.vertices[i];
+            auto reach = vertex_radius(g, options, i) + paints[vertex_styles[i]].stroke_width / 2;
+            boxes[edge_count + i] = { v.pos - Vec2f{ reach, reach }, v.pos + Vec2f{ reach, reach } };
+        }
+
+        index.build(boxes);
+    }
+
+    struct TileKey {
+        size_t x;
+        size_t y;
+    };
+
+    struct TileResult {
+        Image image;
+        // Any element reaches into the tile, even if all of them were too small to draw
+        bool occupied = false;
+        bool drawn = false;
+    };
+
+    auto tile_size = (double)options.tile_size;
+    std::vector<TileKey> level = { { 0, 0 } };
+    std::vector<TileKey> next_level;
+    size_t tiles_written = 0;
+    std::atomic<size_t> shapes_drawn = 0;
+
+    StatsTimer timer(stats, "tiles");
+
+    for (size_t zoom = 0; zoom <= levels.max_zoom && !level.empty(); zoom++) {
+        auto world_size = levels.size / std::ldexp(1.0, (int)zoom);
+        auto scale = tile_size / world_size;
+        next_level.clear();
+
+        // A batch of tiles is drawn in parallel, then handed to write in order on this thread
+        auto batch_size = pool->thread_count() * 4;
+        std::vector<TileResult> results(batch_size);
+
+        for (size_t first = 0; first < level.size(); first += batch_size) {
+            auto count = std::min(batch_size, level.size() - first);
+
+            pool->parallel_for(count, 1, [&](size_t begin, size_t end) {
+                thread_local Rasterizer r;
+                thread_local RasterShape shape;
+                thread_local std::vector<size_t> found;
+
+                for (auto t = begin; t < end; t++) {
+                    auto [tx, ty] = level[first + t];
+                    auto& result = results[t];
+                    result.occupied = false;
+                    result.drawn = false;
+
+                    Vec2f tile_min = levels.origin + Vec2f{ (double)tx, (double)ty } * world_size;
+                    Box tile_box = { tile_min, tile_min + Vec2f{ world_size, world_size } };
+
+                    // Only the elements that intersect the tile are flattened and drawn
+                    found.clear();
+                    index.query(tile_box, [&](size_t id) { found.push_back(id); });
+                    if (found.empty())
+                        continue;
+                    result.occupied = true;
+                    std::sort(found.begin(), found.end());
+
+                    shape.set_transform(tile_min, scale);
+                    for (auto id : found) {
+                        auto& b = boxes[id];
+                        auto pixels = std::max(b.max.x - b.min.x, b.max.y - b.min.y) * scale;
+                        if (pixels < tile_cull_pixels)
+                            continue;
+
+                        if (!result.drawn) {
+                            result.image = Image(options.tile_size, options.tile_size);
+                            result.drawn = true;
+                        }
+
+                        shape.path.clear();
+                        if (id < edge_count) {
+                            shape.style = edge_styles[id];
+                            auto& outline = outlines[id];
+                            if (pixels < tile_simplify_pixels && outline.size() > 1) {
+                                for (size_t i = 0; i < outline.size(); i++) {
+                                    auto p = g.vertices[outline[i]].pos;
+                                    if (i == 0)
+                                        shape.path.move_to(p);
+                                    else
+                                        shape.path.line_to(p);
+                                }
+                            } else {
+                                edge_shape(g, options, id, outline, shape.path);
+                            }
+                        } else {
+                            auto v = id - edge_count;
+                            shape.style = vertex_styles[v];
+                            shape.path.circle(g.vertices[v].pos, vertex_radius(g, options, v));
+                        }
+
+                        auto& paint = paints[shape.style];
+                        finish_shape(shape, paint, tile_size, tile_size);
+                        draw_shape(r, result.image, shape, paint, 0, (long)options.tile_size);
+                        shapes_drawn++;
+                    }
+                }
+            });
+
+            for (size_t t = 0; t < count; t++) {
+                auto key = level[first + t];
+                auto& result = results[t];
+                if (!result.occupied)
+                    continue;
+
+                if (zoom < levels.max_zoom) {
+                    for (size_t c = 0; c < 4; c++)
+                        next_level.push_back({ 2 * key.x + c % 2, 2 * key.y + c / 2 });
+                }
+
+                if (result.drawn) {
+                    write({ .zoom = zoom, .x = key.x, .y = key.y, .image = result.image });
+                    tiles_written++;
+                    result.image = {};
+                }
+            }
+        }
+
+        std::swap(level, next_level);
+    }
+
+    if (stats) {
+        stats->set("styles", styles.size());
+        stats->set("tiles", tiles_written);
+        stats->set("tile-shapes", shapes_drawn);
+    }
+}
+
+// Arcs are flattened to stay within a quarter pixel up to this zoom of the HTML viewer
+static constexpr double html_flatten_zoom = 2;
+
+// Canvas viewer of draw_html. It reads the options from #drawing and the packed arrays from #geometry, buckets the
+// bounds of every shape and label into a pyramid of grids once and then draws only those in the cells in view, the
+// shapes in the same order as the SVG. Drag pans, the wheel zooms around the pointer and a double click fits the drawing again.
+static constexpr std::string_view html_viewer = R"(<script>
+(() => {
+"use strict";
+const drawing = JSON.parse(document.getElementById("drawing").textContent);
+const text = atob(document.getElementById("geometry").textContent);
+const bytes = new Uint8Array(text.length);
+for (let i = 0; i < text.length; i++) bytes[i] = text.charCodeAt(i);
+
+const buffer = bytes.buffer;
+const [vertexCount, edgeCount, pointCount, labelCount] = new Uint32Array(buffer, 0, 4);
+let offset = 16;
+const take = (Type, count) => { const array = new Type(buffer, offset, count); offset += 4 * count; return array; };
+const vertexPos = take(Float32Array, 2 * vertexCount);
+const vertexRadius = take(Float32Array, vertexCount);
+const vertexStyle = take(Uint32Array, vertexCount);
+const edgeStyle = take(Uint32Array, edgeCount);
+const edgeStart = take(Uint32Array, edgeCount + 1);
+const points = take(Float32Array, 2 * pointCount);
+const labelPos = take(Float32Array, 2 * labelCount);
+
+const canvas = document.querySelector("canvas");
+const ctx = canvas.getContext("2d");
+
+// Colors the canvas does not understand, like none, come out transparent
+const color = (c) => { ctx.fillStyle = "#0000"; ctx.fillStyle = c; return ctx.fillStyle; };
+const transparent = color("#0000");
+const styles = drawing.styles.map((s) => ({
+    fill: s["fill-opacity"] > 0 && color(s.fill) !== transparent ? color(s.fill) : null,
+    fillOpacity: s["fill-opacity"],
+    stroke: s["stroke-opacity"] > 0 && s["stroke-width"] > 0 && color(s.stroke) !== transparent ? color(s.stroke) : null,
+    strokeOpacity: s["stroke-opacity"],
+    strokeWidth: s["stroke-width"],
+}));
+
+// Shapes are numbered in drawing order, edges first and vertices after them
+const shapeCount = edgeCount + vertexCount;
+const styleOf = (i) => styles[i < edgeCount ? edgeStyle[i] : vertexStyle[i - edgeCount]];
+const bounds = new Float32Array(4 * shapeCount);
+for (let i = 0; i < shapeCount; i++) {
+    let x0 = Infinity, y0 = Infinity, x1 = -Infinity, y1 = -Infinity;
+    if (i < edgeCount) {
+        for (let p = edgeStart[i]; p < edgeStart[i + 1]; p++) {
+            x0 = Math.min(x0, points[2 * p]); x1 = Math.max(x1, points[2 * p]);
+            y0 = Math.min(y0, points[2 * p + 1]); y1 = Math.max(y1, points[2 * p + 1]);
+        }
+    } else {
+        const v = i - edgeCount, r = vertexRadius[v];
+        x0 = vertexPos[2 * v] - r; x1 = vertexPos[2 * v] + r;
+        y0 = vertexPos[2 * v + 1] - r; y1 = vertexPos[2 * v + 1] + r;
+    }
+    const margin = styleOf(i).strokeWidth / 2;
+    bounds.set([x0 - margin, y0 - margin, x1 + margin, y1 + margin], 4 * i);
+}
+
+// Labels are 10 units high and about 6 wide per character, centered on their point
+const labelBounds = new Float32Array(4 * labelCount);
+for (let l = 0; l < labelCount; l++) {
+    const x = labelPos[2 * l], y = labelPos[2 * l + 1], half = 3 * String(drawing.labels[l]).length;
+    labelBounds.set([x - half, y - 5, x + half, y + 5], 4 * l);
+}
+
+// Pyramid of uniform grids over the view box, every level with cells twice as large as the one below. An item goes
+// into the finest level where its bounds span at most two cells each way, so a view only visits the cells it overlaps
+// and the items stored in them. Returns a query for the items reaching into a rectangle, in order.
+const [boxX, boxY, boxWidth, boxHeight] = drawing["view-box"];
+const gridIndex = (count, bounds) => {
+    const base = Math.max(1, Math.min(1024, Math.ceil(Math.sqrt(count / 2))));
+    const levels = [];
+    for (let side = base, size = 1; ; side = Math.ceil(side / 2), size *= 2) {
+        levels.push({ side, cellWidth: (boxWidth / base || 1) * size, cellHeight: (boxHeight / base || 1) * size });
+        if (side === 1) break;
+    }
+
+    const cells = (level, x0, y0, x1, y1) => {
+        const cell = (v, min, size) => Math.min(level.side - 1, Math.max(0, Math.floor((v - min) / size)));
+        return [cell(x0, boxX, level.cellWidth), cell(y0, boxY, level.cellHeight), cell(x1, boxX, level.cellWidth), cell(y1, boxY, level.cellHeight)];
+    };
+    const itemCells = (level, i) => cells(level, bounds[4 * i], bounds[4 * i + 1], bounds[4 * i + 2], bounds[4 * i + 3]);
+
+    const itemLevel = new Uint8Array(count);
+    for (let i = 0; i < count; i++) {
+        let l = 0;
+        for (; l + 1 < levels.length; l++) {
+            const [cx0, cy0, cx1, cy1] = itemCells(levels[l], i);
+            if (cx1 - cx0 <= 1 && cy1 - cy0 <= 1) break;
+        }
+        itemLevel[i] = l;
+    }
+
+    // Items of cell c of a level are items[start[c]..start[c + 1]], in increasing order
+    const forCells = (i, f) => {
+        const level = levels[itemLevel[i]];
+        const [cx0, cy0, cx1, cy1] = itemCells(level, i);
+        for (let y = cy0; y <= cy1; y++) for (let x = cx0; x <= cx1; x++) f(level, y * level.side + x);
+    };
+    for (const level of levels) level.start = new Uint32Array(level.side * level.side + 1);
+    for (let i = 0; i < count; i++) forCells(i, (level, c) => level.start[c + 1]++);
+    for (const level of levels) {
+        for (let c = 0; c < level.side * level.side; c++) level.start[c + 1] += level.start[c];
+        level.items = new Uint32Array(level.start[level.side * level.side]);
+        level.fill = level.start.slice(0, level.side * level.side);
+    }
+    for (let i = 0; i < count; i++) forCells(i, (level, c) => { level.items[level.fill[c]++] = i; });
+
+    const seen = new Uint32Array(count);
+    let stamp = 0;
+    return (x0, y0, x1, y1, accept) => {
+        const res = [];
+        stamp++;
+        for (const level of levels) {
+            const [cx0, cy0, cx1, cy1] = cells(level, x0, y0, x1, y1);
+            for (let y = cy0; y <= cy1; y++) {
+                for (let x = cx0; x <= cx1; x++) {
+                    const c = y * level.side + x;
+                    for (let k = level.start[c]; k < level.start[c + 1]; k++) {
+                        const i = level.items[k], b = 4 * i;
+                        if (seen[i] === stamp) continue;
+                        seen[i] = stamp;
+                        if (bounds[b] > x1 || bounds[b + 2] < x0 || bounds[b + 1] > y1 || bounds[b + 3] < y0) continue;
+                        if (accept(b)) res.push(i);
+                    }
+                }
+            }
+        }
+        return new Uint32Array(res).sort();
+    };
+};
+
+const shapeIndex = gridIndex(shapeCount, bounds);
+const labelIndex = gridIndex(labelCount, labelBounds);
+
+let scale = 1, tx = 0, ty = 0, pending = false;
+
+const fit = () => {
+    scale = Math.min(canvas.clientWidth / boxWidth, canvas.clientHeight / boxHeight) || 1;
+    tx = (canvas.clientWidth - boxWidth * scale) / 2 - boxX * scale;
+    ty = (canvas.clientHeight - boxHeight * scale) / 2 - boxY * scale;
+};
+
+const draw = () => {
+    pending = false;
+    const ratio = window.devicePixelRatio || 1;
+    const width = canvas.clientWidth, height = canvas.clientHeight;
+    if (canvas.width !== Math.round(width * ratio) || canvas.height !== Math.round(height * ratio)) {
+        canvas.width = Math.round(width * ratio);
+        canvas.height = Math.round(height * ratio);
+    }
+    ctx.setTransform(1, 0, 0, 1, 0, 0);
+    ctx.clearRect(0, 0, canvas.width, canvas.height);
+    ctx.setTransform(ratio * scale, 0, 0, ratio * scale, ratio * tx, ratio * ty);
+    ctx.lineCap = "round";
+
+    const x0 = -tx / scale, y0 = -ty / scale, x1 = (width - tx) / scale, y1 = (height - ty) / scale;
+    // Shapes smaller than half a pixel are left out
+    const minSize = 0.5 / (ratio * scale);
+    const large = (b) => Math.max(bounds[b + 2] - bounds[b], bounds[b + 3] - bounds[b + 1]) >= minSize;
+    for (const i of shapeIndex(x0, y0, x1, y1, large)) {
+        ctx.beginPath();
+        if (i < edgeCount) {
+            const first = edgeStart[i];
+            ctx.moveTo(points[2 * first], points[2 * first + 1]);
+            for (let p = first + 1; p < edgeStart[i + 1]; p++) ctx.lineTo(points[2 * p], points[2 * p + 1]);
+            ctx.closePath();
+        } else {
+            const v = i - edgeCount;
+            ctx.arc(vertexPos[2 * v], vertexPos[2 * v + 1], vertexRadius[v], 0, 2 * Math.PI);
+        }
+        const style = styleOf(i);
+        if (style.fill) {
+            ctx.globalAlpha = style.fillOpacity;
+            ctx.fillStyle = style.fill;
+            ctx.fill();
+        }
+        if (style.stroke) {
+            ctx.globalAlpha = style.strokeOpacity;
+            ctx.strokeStyle = style.stroke;
+            ctx.lineWidth = style.strokeWidth;
+            ctx.stroke();
+        }
+    }
+
+    // Labels go on top once they are large enough to read
+    if (10 * scale >= 4) {
+        ctx.globalAlpha = 1;
+        ctx.fillStyle = "black";
+        ctx.font = "10px sans-serif";
+        ctx.textAlign = "center";
+        ctx.textBaseline = "middle";
+        for (const l of labelIndex(x0, y0, x1, y1, () => true)) ctx.fillText(drawing.labels[l], labelPos[2 * l], labelPos[2 * l + 1]);
+    }
+};
+
+const redraw = () => {
+    if (!pending) {
+        pending = true;
+        requestAnimationFrame(draw);
+    }
+};
+
+let drag = null;
+canvas.addEventListener("pointerdown", (e) => { drag = { x: e.clientX - tx, y: e.clientY - ty }; canvas.setPointerCapture(e.pointerId); });
+canvas.addEventListener("pointermove", (e) => {
+    if (!drag) return;
+    tx = e.clientX - drag.x;
+    ty = e.clientY - drag.y;
+    redraw();
+});
+canvas.addEventListener("pointerup", () => { drag = null; });
+canvas.addEventListener("wheel", (e) => {
+    e.preventDefault();
+    const factor = Math.exp(-e.deltaY * (e.deltaMode ? 0.05 : 0.002));
+    const rect = canvas.getBoundingClientRect();
+    const px = e.clientX - rect.left, py = e.clientY - rect.top;
+    tx = px - (px - tx) * factor;
+    ty = py - (py - ty) * factor;
+    scale *= factor;
+    redraw();
+}, { passive: false });
+canvas.addEventListener("dblclick", () => { fit(); redraw(); });
+window.addEventListener("resize", redraw);
+
+fit();
+draw();
+})();
+</script>
+)";
+
+void draw_html(const Hypergraph& g, const DrawOptions& options, const std::function<void(std::string_view)>& write, ThreadPool* pool, Stats* stats) {
+    static_assert(std::endian::native == std::endian::little, "the html geometry is only implemented for little endian hosts");
+
+    g.validate(true);
+
+    auto box = view_box(g, options);
+
+    std::vector<ShapeStyle> styles;
+    std::vector<uint32_t> vertex_styles;
+    std::vector<uint32_t> edge_styles;
+
+    {
+        StatsTimer timer(stats, "styles");
+        resolve_styles(g, options, styles, vertex_styles, edge_styles);
+    }
+
+    if (stats)
+        stats->set("styles", styles.size());
+
+    std::unique_ptr<ThreadPool> own_pool;
+    pool = use_pool(pool, own_pool, options);
+
+    // Outlines of the edges flattened to polygons in user units, edge i is points [edge_starts[i], edge_starts[i + 1])
+    std::vector<uint32_t> edge_starts(g.edges.size() + 1);
+    std::vector<float> edge_points;
+
+    {
+        StatsTimer timer(stats, "edges");
+
+        // Edges are flattened in parallel batches and appended in order
+        constexpr size_t edges_per_batch = 4096;
+        std::vector<RasterPath> paths(edges_per_batch);
+        for (auto& path : paths)
+            path.scale = html_flatten_zoom;
+
+        for (size_t first = 0; first < g.edges.size(); first += edges_per_batch) {
+            auto count = std::min(edges_per_batch, g.edges.size() - first);
+
+            pool->parallel_for(count, 64, [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto e = first + i;
+                    paths[i].clear();
+                    edge_shape(g, options, e, edge_outline(g, g.edges[e], edge_hull(g, options, e)), paths[i]);
+                }
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                for (auto& p : paths[i].points) {
+                    edge_points.push_back((float)(p.x / html_flatten_zoom));
+                    edge_points.push_back((float)(p.y / html_flatten_zoom));
+                }
+                if (edge_points.size() / 2 > UINT32_MAX)
+                    hypergraph_error("the hyperedge outlines have too many points for html output");
+                edge_starts[first + i + 1] = (uint32_t)(edge_points.size() / 2);
+            }
+        }
+    }
+
+    if (stats)
+        stats->set("outline-points", edge_points.size() / 2);
+
+    // Labels of the edges at the mean of their vertices, then those of the vertices
+    std::vector<float> label_points;
+    nlohmann::json labels = nlohmann::json::array();
+
+    auto add_label = [&](Vec2f p, uint32_t label) {
+        label_points.push_back((float)p.x);
+        label_points.push_back((float)p.y);
+        labels.push_back(g.strings.get(label));
+    };
+
+    for (size_t i = 0; i < g.edges.size(); i++) {
+        if (g.edge_styles.has(i, StyleColumns::LABEL))
+            add_label(edge_mean(g, g.edges[i]), g.edge_styles.label[i]);
+    }
+    for (size_t i = 0; i < g.vertices.size(); i++) {
+        if (g.vertex_styles.has(i, StyleColumns::LABEL))
+            add_label(g.vertices[i].pos, g.vertex_styles.label[i]);
+    }
+
+    // Every array is made of 4 byte values so each starts aligned for the typed arrays of the viewer
+    std::string geometry;
+    {
+        StatsTimer timer(stats, "pack");
+
+        auto append = [&](const void* data, size_t size) { geometry.append((const char*)data, size); };
+
+        uint32_t counts[4] = { (uint32_t)g.vertices.size(), (uint32_t)g.edges.size(), (uint32_t)(edge_points.size() / 2), (uint32_t)labels.size() };
+        append(counts, sizeof(counts));
+
+        std::vector<float> vertex_values(2 * g.vertices.size());
+        for (size_t i = 0; i < g.vertices.size(); i++) {
+            vertex_values[2 * i] = (float)g.vertices[i].pos.x;
+            vertex_values[2 * i + 1] = (float)g.vertices[i].pos.y;
+        }
+        append(vertex_values.data(), vertex_values.size() * sizeof(float));
+
+        vertex_values.resize(g.vertices.size());
+        for (size_t i = 0; i < g.vertices.size(); i++)
+            vertex_values[i] = (float)vertex_radius(g, options, i);
+        append(vertex_values.data(), vertex_values.size() * sizeof(float));
+
+        append(vertex_styles.data(), vertex_styles.size() * sizeof(uint32_t));
+        append(edge_styles.data(), edge_styles.size() * sizeof(uint32_t));
+        append(edge_starts.data(), edge_starts.size() * sizeof(uint32_t));
+        append(edge_points.data(), edge_points.size() * sizeof(float));
+        append(label_points.data(), label_points.size() * sizeof(float));
+    }
+
+    StatsTimer timer(stats, "encode");
+
+    nlohmann::json style_list = nlohmann::json::array();
+    for (auto& style : styles) {
+        style_list.push_back({
+            { "fill", style.fill },
+            { "fill-opacity", style.fill_opacity },
+            { "stroke", style.stroke },
+            { "stroke-opacity", style.stroke_opacity },
+            { "stroke-width", style.stroke_width },
+        });
+    }
+
+    nlohmann::json drawing = {
+        { "view-box", { box.min.x, box.min.y, box.size.x, box.size.y } },
+        { "styles", style_list },
+        { "labels", labels },
+    };
+
+    // A < only occurs inside json strings, escaping it keeps the text from closing the script element
+    std::string drawing_text;
+    for (auto c : drawing.dump()) {
+        if (c == '<')
+            drawing_text += "\\u003c";
+        else
+            drawing_text += c;
+    }
+
+    write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>Hypergraph</title>\n");
+    write("<style>html,body{margin:0;height:100%;overflow:hidden}canvas{display:block;width:100%;height:100%;cursor:grab;touch-action:none}</style>\n");
+    write("</head>\n<body>\n<canvas></canvas>\n<script type=\"application/json\" id=\"drawing\">");
+    write(drawing_text);
+    write("</script>\n<script type=\"application/octet-stream\" id=\"geometry\">");
+
+    // Encoded in pieces of a whole number of 3 byte groups so only the end is padded
+    constexpr size_t encode_chunk = 3 << 18;
+    for (size_t i = 0; i < geometry.size(); i += encode_chunk)
+        write(base64_encode(std::string_view(geometry).substr(i, encode_chunk)));
+
+    write("</script>\n");
+    write(html_viewer);
+    write("</body>\n</html>\n");
+}
+
+std::string draw_html(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool, Stats* stats) {
+    std::string res;
+    draw_html(g, options, [&](std::string_view str) { res.append(str); }, pool, stats);
+    return res;
+}
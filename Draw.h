@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Hypergraph.h"
+#include "Raster.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+// Paint used for shapes that do not set their own
+struct PaintDefaults {
+    std::string fill;
+    double fill_opacity;
+    std::string stroke;
+    double stroke_opacity;
+    double stroke_width;
+};
+
+struct DrawOptions {
+    struct {
+        double top = 30;
+        double bottom = 30;
+        double left = 30;
+        double right = 30;
+    } padding;
+
+    double vertex_radius = 12;
+    double edge_draw_radius = 18;
+
+    PaintDefaults vertex = { "black", 1, "black", 1, 1 };
+    PaintDefaults edge = { "transparent", 0, "black", 1, 1 };
+    bool edge_hull = false;
+
+    // Decimals kept in coordinates, between 0 and 15
+    int precision = 6;
+    // 0 uses every hardware thread
+    size_t threads = 0;
+
+    // Size of raster output in pixels, a height of 0 follows from the width and the aspect ratio of the drawing
+    size_t raster_width = 1024;
+    size_t raster_height = 0;
+
+    // Width and height of every tile of draw_tiles in pixels, and the deepest zoom level. Without a zoom the deepest
+    // level shows the drawing at one pixel per unit.
+    size_t tile_size = 256;
+    std::optional<size_t> tile_max_zoom;
+
+    // Reads the drawing options of the json format, missing options keep their defaults
+    static DrawOptions from_json(const nlohmann::json& options);
+};
+
+// Vertices of e in the order the outline of its shape visits them, with hull only those on its convex hull
+std::vector<size_t> edge_outline(const Hypergraph& g, const Hyperedge& e, bool hull);
+
+// Renders g as an SVG document, every vertex must have a position. The document is passed to write in pieces as it
+// is produced. Edges are rendered on pool, or on a pool of options.threads threads when pool is null.
+// The time of each phase and the number of styles are recorded in stats when it is set.
+void draw_svg(const Hypergraph& g, const DrawOptions& options, const std::function<void(std::string_view)>& write, ThreadPool* pool = nullptr, Stats* stats = nullptr);
+
+// Largest width or height of raster output
+static constexpr size_t max_raster_size = 32768;
+
+// Renders the same shapes as draw_svg into an image, labels are not drawn
+Image draw_raster(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool = nullptr, Stats* stats = nullptr);
+
+// Deepest zoom level of draw_tiles
+static constexpr size_t max_tile_zoom = 24;
+
+// Square area of the drawing covered by the tiles, level z splits it into 2^z x 2^z tiles
+struct TileLevels {
+    Vec2f origin;
+    double size = 0;
+    size_t max_zoom = 0;
+};
+
+TileLevels tile_levels(const Hypergraph& g, const DrawOptions& options);
+
+struct Tile {
+    size_t zoom;
+    size_t x;
+    size_t y;
+    const Image& image;
+};
+
+// Renders a zoom pyramid of square tiles, level 0 is one tile holding the whole drawing and every level doubles the
+// resolution. The elements reaching into a tile are found with a spatial index so each tile only costs what it shows.
+// Shapes smaller than half a pixel at a level are left out of it and small hyperedges are simplified to the polygon
+// through their vertices. Tiles nothing is drawn on are skipped, write is called on the calling thread.
+void draw_tiles(const Hypergraph& g, const DrawOptions& options, const std::function<void(const Tile&)>& write, ThreadPool* pool = nullptr, Stats* stats = nullptr);
+
+// Renders g as an SVG document into a string
+std::string draw_svg(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool = nullptr, Stats* stats = nullptr);
+
+// Renders g as one self-contained HTML page that draws it on a canvas with pan and zoom. The vertex centres, radii
+// and the hyperedge outlines of draw_svg flattened to polygons are packed into little endian float and index arrays
+// embedded in base64, the page keeps them in typed arrays and only draws the shapes in view. The page is passed to
+// write in pieces, edges are flattened on pool or on a pool of options.threads threads when pool is null.
+void draw_html(const Hypergraph& g, const DrawOptions& options, const std::function<void(std::string_view)>& write, ThreadPool* pool = nullptr, Stats* stats = nullptr);
+
+// Renders g as an HTML page into a string
+std::string draw_html(const Hypergraph& g, const DrawOptions& options, ThreadPool* pool = nullptr, Stats* stats = nullptr);
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Incidence.h"
+#include "LayoutProgress.h"
+#include "QuadTree.h"
+#include "ThreadPool.h"
+#include "Vec2f.h"
+
+struct ForceLayoutOptions {
+    size_t iterations = 300;
+    uint64_t seed = 0;
+    double edge_length = 60;
+    double theta = 0.8;
+    double gravity = 0.05;
+
+    // Largest distance a vertex may move in the first iteration, 0 picks it from the size of the graph
+    double temperature = 0;
+
+    // No iteration starts after it, the positions are left as they are
+    Deadline deadline = no_deadline;
+};
+
+// Places n points uniformly at random in a square centered on the origin that gives each point about edge_length^2 of area
+inline std::vector<Vec2f> random_positions(size_t n, double edge_length, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    double half = edge_length * std::sqrt((double)n) / 2;
+    std::uniform_real_distribution<double> dist(-half, half);
+
+    std::vector<Vec2f> res(n);
+    for (auto& p : res) {
+        p.x = dist(rng);
+        p.y = dist(rng);
+    }
+    return res;
+}
+
+// Fruchterman-Reingold style force directed layout that works on hyperedges directly.
+// Every vertex is pulled towards the centroid of each hyperedge it belongs to and pushed away from all other
+// vertices, with the repulsion approximated by Barnes-Hut on a quadtree so each iteration is O(n log n).
+// Forces are computed from the previous positions only, so splitting the passes over a thread pool gives the same
+// result as running them serially.
+struct ForceLayout {
+    const Incidence& incidence;
+    std::vector<Vec2f>& positions;
+    ForceLayoutOptions options;
+    ThreadPool* pool;
+
+    // Optional weight of each vertex for repulsion, used for contracted vertices when laying out coarse levels
+    const std::vector<double>* masses = nullptr;
+
+    // Vertices that move, every vertex when empty. The others keep their positions but still push and pull, so a
+    // step only costs time in the number of moving vertices and their hyperedges.
+    std::vector<size_t> active;
+
+    size_t iteration = 0;
+    double start_temperature;
+
+    // Sum of the squared net forces on the moving vertices at the start of the last iteration, measured on the way so
+    // that it costs no extra pass over the vertices
+    double energy = 0;
+
+    ForceLayout(const Incidence& incidence, std::vector<Vec2f>& positions, ForceLayoutOptions options, ThreadPool* pool = nullptr)
+        : incidence(incidence), positions(positions), options(options), pool(pool) {
+        start_temperature = options.temperature > 0 ? options.temperature : std::max(options.edge_length, options.edge_length * std::sqrt((double)positions.size()) / 10);
+    }
+
+    bool done() const { return iteration >= options.iterations; }
+
+    double temperature() const { return start_temperature * (1.0 - (double)iteration / (double)(options.iterations + 1)); }
+
+    // Turns positions into the positions of every vertex of the hypergraph for the frames of a LayoutProgress, when
+    // this layout does not cover all of them
+    std::function<std::vector<Vec2f>(const std::vector<Vec2f>&)> frame_positions;
+
+    // Runs the remaining iterations, or fewer when the deadline passes, and adds them to progress when it is set
+    void run(LayoutProgress* progress = nullptr) {
+        auto start = iteration;
+        while (!done() && !past_deadline(options.deadline)) {
+            step();
+            if (progress && progress->frame_due())
+                progress->on_frame(frame_positions ? frame_positions(positions) : positions);
+        }
+        if (progress) {
+            progress->iterations += iteration - start;
+            progress->out_of_time = progress->out_of_time || !done();
+        }
+    }
+
+    void step() {
+        if (!active.empty()) {
+            step_active();
+            return;
+        }
+
+        auto n = positions.size();
+        auto k = options.edge_length;
+        auto t = temperature();
+
+        tree.build(positions, masses);
+
+        centroids.resize(incidence.edge_count);
+        parallel_for(incidence.edge_count, 1024, [&](size_t begin, size_t end) {
+            for (auto e = begin; e < end; e++)
+                centroids[e] = edge_centroid(e);
+        });
+
+        next.resize(n);
+        force_lengths.resize(n);
+        parallel_for(n, 256, [&](size_t begin, size_t end) {
+            for (auto v = begin; v < end; v++)
+                next[v] = moved_vertex(v, k, t, v, nullptr, &force_lengths[v]);
+        });
+
+        positions.swap(next);
+        sum_energy();
+        iteration++;
+    }
+
+    // Length of the net force on every vertex at the current positions. Small everywhere once a layout has settled,
+    // large around whatever changed since.
+    std::vector<double> forces() {
+        auto k = options.edge_length;
+        tree.build(positions, masses);
+        centroids.resize(incidence.edge_count);
+        parallel_for(incidence.edge_count, 1024, [&](size_t begin, size_t end) {
+            for (auto e = begin; e < end; e++)
+                centroids[e] = edge_centroid(e);
+        });
+
+        std::vector<double> res(positions.size());
+        parallel_for(positions.size(), 256, [&](size_t begin, size_t end) {
+            for (auto v = begin; v < end; v++)
+                res[v] = (moved_vertex(v, k, INFINITY, v, nullptr) - positions[v]).length();
+        });
+        return res;
+    }
+
+  private:
+    QuadTree tree;
+    std::vector<Vec2f> centroids;
+    std::vector<Vec2f> next;
+    std::vector<double> force_lengths;
+
+    // Pinned vertices never move so their tree is built once, moving vertices have weight 0 in it
+    QuadTree pinned_tree;
+    std::vector<double> pinned_masses;
+    std::vector<double> active_masses;
+    std::vector<size_t> active_edges;
+
+    void step_active() {
+        auto k = options.edge_length;
+        auto t = temperature();
+
+        if (iteration == 0 || pinned_masses.empty()) {
+            pinned_masses = masses ? *masses : std::vector<double>(positions.size(), 1.0);
+            active_masses.clear();
+            for (auto v : active) {
+                active_masses.push_back(pinned_masses[v]);
+                pinned_masses[v] = 0;
+            }
+            pinned_tree.build(positions, &pinned_masses);
+
+            active_edges.clear();
+            for (auto v : active)
+                active_edges.insert(active_edges.end(), incidence.vertex_begin(v), incidence.vertex_end(v));
+            std::sort(active_edges.begin(), active_edges.end());
+            active_edges.erase(std::unique(active_edges.begin(), active_edges.end()), active_edges.end());
+            centroids.resize(incidence.edge_count);
+        }
+
+        next.resize(active.size());
+        for (size_t i = 0; i < active.size(); i++)
+            next[i] = positions[active[i]];
+        tree.build(next, &active_masses);
+
+        parallel_for(active_edges.size(), 1024, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++)
+                centroids[active_edges[i]] = edge_centroid(active_edges[i]);
+        });
+
+        force_lengths.resize(active.size());
+        parallel_for(active.size(), 256, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++)
+                next[i] = moved_vertex(active[i], k, t, i, &pinned_tree, &force_lengths[i]);
+        });
+
+        for (size_t i = 0; i < active.size(); i++)
+            positions[active[i]] = next[i];
+        sum_energy();
+        iteration++;
+    }
+
+    // In order so that the sum does not depend on the thread count
+    void sum_energy() {
+        energy = 0;
+        for (auto f : force_lengths)
+            energy += f * f;
+    }
+
+    template <typename F>
+    void parallel_for(size_t count, size_t grain, F&& f) {
+        if (pool)
+            pool->parallel_for(count, grain, f);
+        else
+            f((size_t)0, count);
+    }
+
+    Vec2f edge_centroid(size_t e) const {
+        Vec2f sum = {};
+        for (auto v = incidence.edge_begin(e); v != incidence.edge_end(e); v++)
+            sum += positions[*v];
+        return incidence.edge_size(e) > 0 ? sum / (double)incidence.edge_size(e) : sum;
+    }
+
+    // tree_index is the index of v in tree, pinned is a second tree with the vertices that do not move. The length of
+    // the net force is stored in force when it is set.
+    Vec2f moved_vertex(size_t v, double k, double t, size_t tree_index, const QuadTree* pinned, double* force = nullptr) const {
+        auto p = positions[v];
+        Vec2f disp = {};
+
+        // Repulsion k^2 / d from every other vertex
+        auto repel = [&](Vec2f center, double mass) {
+            auto delta = p - center;
+            auto d2 = delta.x * delta.x + delta.y * delta.y;
+            if (d2 < 1e-9 * k * k) {
+                // Separate coincident points in a direction that only depends on the vertex
+                delta = Vec2f{ std::cos(v * 2.399963), std::sin(v * 2.399963) } * (0.01 * k);
+                d2 = 0.0001 * k * k;
+            }
+            disp += delta * (k * k * mass / d2);
+        };
+        tree.visit(p, tree_index, options.theta, repel);
+        if (pinned)
+            pinned->visit(p, v, options.theta, repel);
+
+        // Attraction d^2 / k towards the centroid of every incident hyperedge
+        for (auto e = incidence.vertex_begin(v); e != incidence.vertex_end(v); e++) {
+            if (incidence.edge_size(*e) < 2)
+                continue;
+            auto delta = centroids[*e] - p;
+            disp += delta * (std::sqrt(delta.x * delta.x + delta.y * delta.y) / k);
+        }
+
+        disp -= p * options.gravity;
+
+        auto len = disp.length();
+        if (force)
+            *force = len;
+        if (len <= 0)
+            return p;
+
+        return p + disp * (std::min(len, t) / len);
+    }
+};
@@ -0,0 +1,74 @@
+#include "Generator.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "ForceLayout.h"
+
+EdgeSizeDistribution GeneratorOptions::parse_distribution(const std::string& name) {
+    if (name == "uniform")
+        return EdgeSizeDistribution::UNIFORM;
+    if (name == "power-law")
+        return EdgeSizeDistribution::POWER_LAW;
+    hypergraph_error("edge size distribution must be either \"uniform\" or \"power-law\"");
+}
+
+Hypergraph generate_hypergraph(const GeneratorOptions& options) {
+    if (options.vertex_count == 0)
+        hypergraph_error("vertex count must be positive");
+    if (options.min_edge_size == 0 || options.min_edge_size > options.max_edge_size)
+        hypergraph_error("edge sizes must satisfy 0 < min <= max");
+    if (options.communities == 0 || options.communities > options.vertex_count)
+        hypergraph_error("community count must be between 1 and the vertex count");
+    if (options.mixing < 0 || options.mixing > 1)
+        hypergraph_error("mixing must be between 0 and 1");
+
+    std::mt19937_64 rng(options.seed);
+
+    auto max_size = std::min(options.max_edge_size, options.vertex_count);
+    auto min_size = std::min(options.min_edge_size, max_size);
+
+    std::vector<double> size_weights;
+    for (auto k = min_size; k <= max_size; k++)
+        size_weights.push_back(options.size_distribution == EdgeSizeDistribution::POWER_LAW ? std::pow((double)k, -options.exponent) : 1.0);
+    std::discrete_distribution<size_t> edge_size(size_weights.begin(), size_weights.end());
+
+    std::uniform_int_distribution<size_t> community(0, options.communities - 1);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    // Community c holds the vertices [c * n / communities, (c + 1) * n / communities)
+    auto community_vertex = [&](size_t c) {
+        auto begin = c * options.vertex_count / options.communities;
+        auto end = (c + 1) * options.vertex_count / options.communities;
+        return std::uniform_int_distribution<size_t>(begin, end - 1)(rng);
+    };
+
+    Hypergraph res;
+    res.vertices.resize(options.vertex_count);
+    res.edges.resize(options.edge_count);
+
+    for (auto& e : res.edges) {
+        auto size = min_size + edge_size(rng);
+        auto home = community(rng);
+
+        // Small communities may not have enough distinct vertices, give up on them after a few tries
+        size_t attempts = 0;
+        while (e.vertices.size() < size) {
+            auto c = attempts < 8 * size && unit(rng) >= options.mixing ? home : community(rng);
+            auto v = community_vertex(c);
+            attempts++;
+            if (std::find(e.vertices.begin(), e.vertices.end(), v) == e.vertices.end())
+                e.vertices.push_back(v);
+        }
+    }
+
+    if (options.positions) {
+        // Spread out the same way the force layout starts, which keeps the density independent of the size
+        res.set_positions(random_positions(options.vertex_count, 60, options.seed));
+    }
+
+    return res;
+}
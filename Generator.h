@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "Hypergraph.h"
+
+enum class EdgeSizeDistribution {
+    UNIFORM,
+    POWER_LAW,
+};
+
+struct GeneratorOptions {
+    size_t vertex_count = 100;
+    size_t edge_count = 100;
+    uint64_t seed = 0;
+
+    // Hyperedge sizes are drawn from [min_edge_size, max_edge_size], either uniformly or with P(k) ~ k^-exponent
+    EdgeSizeDistribution size_distribution = EdgeSizeDistribution::UNIFORM;
+    size_t min_edge_size = 2;
+    size_t max_edge_size = 5;
+    double exponent = 2.5;
+
+    // Vertices are split into this many equal communities, every hyperedge belongs to one of them and each of its
+    // vertices is taken from a random community instead with probability mixing
+    size_t communities = 1;
+    double mixing = 0.1;
+
+    // Give every vertex a random position so the result can be drawn without a layout
+    bool positions = false;
+
+    static EdgeSizeDistribution parse_distribution(const std::string& name);
+};
+
+// Builds a random hypergraph, the same options always give the same hypergraph
+Hypergraph generate_hypergraph(const GeneratorOptions& options);
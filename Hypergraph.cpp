@@ -0,0 +1,692 @@
+#include "Hypergraph.h"
+
+#include <stdarg.h>
+
+#include <cmath>
+#include <string>
+
+void hypergraph_error(const char* fmt, ...) {
+    char msg[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    throw HypergraphError(msg);
+}
+
+// Stores value for element i in column, which grows to reach it
+template <typename T>
+static void set_column(std::vector<T>& column, size_t i, T value) {
+    if (column.size() <= i)
+        column.resize(i + 1);
+    column[i] = value;
+}
+
+void StyleColumns::set(size_t i, const std::string& key, const nlohmann::json& val, StringPool& strings) {
+    uint8_t attribute = 0;
+    if (val.is_number()) {
+        auto number = val.get<double>();
+        if (key == "radius") {
+            set_column(radius, i, number);
+            attribute = RADIUS;
+        } else if (key == "fill-opacity") {
+            set_column(fill_opacity, i, number);
+            attribute = FILL_OPACITY;
+        } else if (key == "stroke-opacity") {
+            set_column(stroke_opacity, i, number);
+            attribute = STROKE_OPACITY;
+        } else if (key == "stroke-width") {
+            set_column(stroke_width, i, number);
+            attribute = STROKE_WIDTH;
+        }
+    } else if (val.is_string()) {
+        auto& str = val.get_ref<const std::string&>();
+        if (key == "fill") {
+            set_column(fill, i, strings.intern(str));
+            attribute = FILL;
+        } else if (key == "stroke") {
+            set_column(stroke, i, strings.intern(str));
+            attribute = STROKE;
+        } else if (key == "label") {
+            set_column(label, i, strings.intern(str));
+            attribute = LABEL;
+        }
+    } else if (val.is_boolean()) {
+        if (key == "convex-hull") {
+            set_column(convex_hull, i, (uint8_t)val.get<bool>());
+            attribute = CONVEX_HULL;
+        }
+    }
+
+    if (attribute) {
+        if (present.size() <= i)
+            present.resize(i + 1);
+        present[i] |= attribute;
+    } else {
+        extras.push_back({ i, strings.intern(key), val });
+    }
+}
+
+Style StyleColumns::get(size_t i, const StringPool& strings) const {
+    Style res;
+    if (i >= present.size() || !present[i])
+        return res;
+
+    auto bits = present[i];
+    if (bits & RADIUS)
+        res.radius = radius[i];
+    if (bits & FILL)
+        res.fill = strings.get(fill[i]);
+    if (bits & FILL_OPACITY)
+        res.fill_opacity = fill_opacity[i];
+    if (bits & STROKE)
+        res.stroke = strings.get(stroke[i]);
+    if (bits & STROKE_OPACITY)
+        res.stroke_opacity = stroke_opacity[i];
+    if (bits & STROKE_WIDTH)
+        res.stroke_width = stroke_width[i];
+    if (bits & CONVEX_HULL)
+        res.convex_hull = convex_hull[i] != 0;
+    if (bits & LABEL)
+        res.label = strings.get(label[i]);
+    return res;
+}
+
+// Numbers written as they most likely came in, 5 instead of 5.0
+static nlohmann::json number_json(double v) {
+    if (v == std::floor(v) && std::fabs(v) < 9007199254740992.0)
+        return (int64_t)v;
+    return v;
+}
+
+// Calls f(key, value) for the attributes of element i that are kept in columns
+template <typename F>
+static void visit_columns(const StyleColumns& columns, size_t i, const StringPool& strings, F&& f) {
+    if (!columns.has(i, 0xff))
+        return;
+
+    auto style = columns.get(i, strings);
+    if (style.radius)
+        f("radius", number_json(*style.radius));
+    if (style.fill)
+        f("fill", *style.fill);
+    if (style.fill_opacity)
+        f("fill-opacity", number_json(*style.fill_opacity));
+    if (style.stroke)
+        f("stroke", *style.stroke);
+    if (style.stroke_opacity)
+        f("stroke-opacity", number_json(*style.stroke_opacity));
+    if (style.stroke_width)
+        f("stroke-width", number_json(*style.stroke_width));
+    if (style.convex_hull)
+        f("convex-hull", *style.convex_hull);
+    if (style.label)
+        f("label", *style.label);
+}
+
+void StyleColumns::visit(const StringPool& strings, const std::function<void(size_t, std::string_view, const nlohmann::json&)>& f) const {
+    for (size_t i = 0; i < present.size(); i++)
+        visit_columns(*this, i, strings, [&](std::string_view key, const nlohmann::json& val) { f(i, key, val); });
+
+    for (auto& extra : extras)
+        f(extra.element, strings.get(extra.key), extra.value);
+}
+
+void StyleColumns::write(const StringPool& strings, nlohmann::json& objects, size_t first) const {
+    auto end = first + objects.size();
+    for (auto i = first; i < end; i++)
+        visit_columns(*this, i, strings, [&](std::string_view key, const nlohmann::json& val) { objects[i - first][std::string(key)] = val; });
+
+    for (auto& extra : extras) {
+        if (extra.element >= first && extra.element < end)
+            objects[extra.element - first][std::string(strings.get(extra.key))] = extra.value;
+    }
+}
+
+void Hypergraph::validate(bool positions) const {
+    if (positions) {
+        for (auto& v : vertices) {
+            if (!v.has_pos)
+                hypergraph_error("vertex missing position");
+        }
+    }
+
+    for (auto& e : edges) {
+        for (auto v : e.vertices) {
+            if (v >= vertices.size())
+                hypergraph_error("edges[].vertices[] must be an index into the list of vertices");
+        }
+    }
+}
+
+namespace {
+
+// Streaming parser for the json format.
+// Builds the vertices and edges directly from SAX events, so memory grows with the number of elements and their
+// attributes instead of the size of the json text. Objects and arrays under other keys are built up on their own and
+// stored as an option or attribute once they are complete.
+struct InputReader : nlohmann::json::json_sax_t {
+    using json = nlohmann::json;
+
+    Hypergraph graph;
+    bool require_positions;
+
+    InputReader(bool require_positions) : require_positions(require_positions) {}
+
+    bool has_vertices = false;
+    bool has_edges = false;
+
+    enum Scope { ROOT, VERTICES, VERTEX, POS, EDGES, EDGE, EDGE_VERTICES };
+
+    std::vector<Scope> scopes;
+    std::string current_key;
+
+    // Objects and arrays of options and attributes being built, each with the key it goes under in its parent
+    std::vector<std::pair<std::string, json>> nested;
+
+    bool vertices_object = false;
+    size_t pos_count = 0;
+
+    bool null() override { return value(json()); }
+    bool boolean(bool val) override { return value(val); }
+    bool number_integer(number_integer_t val) override { return value(val); }
+    bool number_unsigned(number_unsigned_t val) override { return value(val); }
+    bool number_float(number_float_t val, const string_t&) override { return value(val); }
+    bool string(string_t& val) override { return value(std::move(val)); }
+    bool binary(binary_t&) override { return value(json()); }
+
+    bool key(string_t& val) override {
+        current_key = std::move(val);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (!nested.empty()) {
+            begin_nested(json::object());
+            return true;
+        }
+        if (scopes.empty()) {
+            scopes.push_back(ROOT);
+            return true;
+        }
+
+        switch (scopes.back()) {
+        case ROOT:
+            if (current_key == "vertices") {
+                has_vertices = true;
+                vertices_object = true;
+                scopes.push_back(VERTICES);
+            } else if (current_key == "edges") {
+                hypergraph_error("edges must be an array");
+            } else {
+                begin_nested(json::object());
+            }
+            break;
+        case VERTICES:
+            add_vertex();
+            scopes.push_back(VERTEX);
+            break;
+        case EDGES:
+            graph.edges.push_back({});
+            has_edge_vertices = false;
+            scopes.push_back(EDGE);
+            break;
+        case VERTEX:
+            if (current_key == "pos")
+                hypergraph_error("vertex has invalid position data");
+            begin_nested(json::object());
+            break;
+        case EDGE:
+            if (current_key == "vertices")
+                hypergraph_error("edges[].vertices must be an array");
+            begin_nested(json::object());
+            break;
+        case POS:
+            hypergraph_error("vertex has invalid position data");
+        case EDGE_VERTICES:
+            hypergraph_error("edges[].vertices[] must be an index into the list of vertices");
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (!nested.empty()) {
+            end_nested();
+            return true;
+        }
+
+        auto scope = scopes.back();
+        scopes.pop_back();
+
+        if (scope == VERTEX && require_positions && !graph.vertices[current_vertex].has_pos)
+            hypergraph_error("vertex missing position");
+        if (scope == EDGE && !has_edge_vertices)
+            hypergraph_error("edge missing list of vertices");
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (!nested.empty()) {
+            begin_nested(json::array());
+            return true;
+        }
+        if (scopes.empty())
+            hypergraph_error("input must be an object");
+
+        switch (scopes.back()) {
+        case ROOT:
+            if (current_key == "vertices") {
+                has_vertices = true;
+                scopes.push_back(VERTICES);
+            } else if (current_key == "edges") {
+                has_edges = true;
+                scopes.push_back(EDGES);
+            } else {
+                begin_nested(json::array());
+            }
+            break;
+        case VERTICES:
+            begin_nested(json::array());
+            break;
+        case EDGES:
+            hypergraph_error("edge missing list of vertices");
+        case VERTEX:
+            if (current_key == "pos") {
+                pos_count = 0;
+                scopes.push_back(POS);
+            } else {
+                begin_nested(json::array());
+            }
+            break;
+        case EDGE:
+            if (current_key == "vertices") {
+                has_edge_vertices = true;
+                scopes.push_back(EDGE_VERTICES);
+            } else {
+                begin_nested(json::array());
+            }
+            break;
+        case POS:
+            hypergraph_error("vertex has invalid position data");
+        case EDGE_VERTICES:
+            hypergraph_error("edges[].vertices[] must be an index into the list of vertices");
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (!nested.empty()) {
+            end_nested();
+            return true;
+        }
+
+        auto scope = scopes.back();
+        scopes.pop_back();
+
+        if (scope == POS) {
+            if (pos_count != 2)
+                hypergraph_error("vertex has invalid position data");
+            graph.vertices[current_vertex].has_pos = true;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        hypergraph_error("invalid json at byte %zu: %s", position, ex.what());
+    }
+
+    // Checks what can only be checked once the whole document has been read
+    void finish() {
+        if (!has_vertices && require_positions)
+            hypergraph_error("missing vertices field");
+
+        if (!has_edges)
+            hypergraph_error("missing edges field");
+
+        if (!require_positions) {
+            // Vertices that are only referenced by edges are created without a position
+            for (auto& e : graph.edges) {
+                for (auto v : e.vertices) {
+                    if (v >= graph.vertices.size())
+                        graph.vertices.resize(v + 1);
+                }
+            }
+        }
+
+        graph.validate(require_positions);
+    }
+
+  private:
+    size_t current_vertex = 0;
+    bool has_edge_vertices = false;
+
+    // Creates the vertex the next entry of vertices stands for and makes it current
+    void add_vertex() {
+        if (vertices_object) {
+            try {
+                current_vertex = std::stoul(current_key);
+            } catch (...) {
+                hypergraph_error("keys in vertices object must be indexes");
+            }
+        } else {
+            current_vertex = graph.vertices.size();
+        }
+
+        if (graph.vertices.size() < current_vertex + 1)
+            graph.vertices.resize(current_vertex + 1);
+    }
+
+    void begin_nested(json container) { nested.emplace_back(current_key, std::move(container)); }
+
+    void add_nested(json&& val) {
+        auto& parent = nested.back().second;
+        if (parent.is_object())
+            parent[current_key] = std::move(val);
+        else
+            parent.push_back(std::move(val));
+    }
+
+    // Adds the innermost nested value to its parent, or stores it like a scalar once it is the whole value
+    void end_nested() {
+        auto [key, val] = std::move(nested.back());
+        nested.pop_back();
+        current_key = std::move(key);
+        if (!nested.empty())
+            add_nested(std::move(val));
+        else
+            value(std::move(val));
+    }
+
+    bool value(json&& val) {
+        if (!nested.empty()) {
+            add_nested(std::move(val));
+            return true;
+        }
+
+        if (scopes.empty())
+            hypergraph_error("input must be an object");
+
+        switch (scopes.back()) {
+        case ROOT:
+            if (current_key == "vertices")
+                hypergraph_error("vertices must be an array or object");
+            if (current_key == "edges")
+                hypergraph_error("edges must be an array");
+            graph.options[current_key] = std::move(val);
+            break;
+        case VERTICES:
+            // Entries that are not objects stand for a vertex without position or attributes
+            add_vertex();
+            if (require_positions)
+                hypergraph_error("vertex missing position");
+            break;
+        case EDGES:
+            hypergraph_error("edge missing list of vertices");
+        case VERTEX:
+            if (current_key == "pos")
+                hypergraph_error("vertex has invalid position data");
+            graph.set_vertex_style(current_vertex, current_key, val);
+            break;
+        case POS:
+            if (!val.is_number() || pos_count >= 2)
+                hypergraph_error("vertex has invalid position data");
+            (pos_count++ == 0 ? graph.vertices[current_vertex].pos.x : graph.vertices[current_vertex].pos.y) = val.get<double>();
+            break;
+        case EDGE:
+            if (current_key == "vertices")
+                hypergraph_error("edges[].vertices must be an array");
+            graph.set_edge_style(graph.edges.size() - 1, current_key, val);
+            break;
+        case EDGE_VERTICES:
+            if (!val.is_number_unsigned())
+                hypergraph_error("edges[].vertices[] must be an index into the list of vertices");
+            graph.edges.back().vertices.push_back(val.get<size_t>());
+            break;
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+Hypergraph read_json_hypergraph(FILE* file, bool require_positions) {
+    InputReader reader(require_positions);
+    nlohmann::json::sax_parse(file, &reader);
+    reader.finish();
+    return std::move(reader.graph);
+}
+
+Hypergraph read_json_hypergraph(std::string_view text, bool require_positions) {
+    InputReader reader(require_positions);
+    nlohmann::json::sax_parse(text, &reader);
+    reader.finish();
+    return std::move(reader.graph);
+}
+
+Hypergraph hypergraph_from_json(const nlohmann::json& json) {
+    Hypergraph res;
+
+    if (!json.is_object())
+        hypergraph_error("input must be an object");
+
+    if (!json.contains("edges") || !json["edges"].is_array())
+        hypergraph_error("missing edges field");
+
+    auto read_vertex = [&](size_t index, const nlohmann::json& v) {
+        if (res.vertices.size() < index + 1)
+            res.vertices.resize(index + 1);
+
+        if (!v.is_object())
+            return;
+
+        auto& vertex = res.vertices[index];
+        for (auto& p : v.items()) {
+            if (p.key() != "pos") {
+                res.set_vertex_style(index, p.key(), p.value());
+                continue;
+            }
+
+            auto& pos = p.value();
+            if (pos.is_array() && pos.size() == 2 && pos[0].is_number() && pos[1].is_number()) {
+                vertex.pos = { pos[0].get<double>(), pos[1].get<double>() };
+                vertex.has_pos = true;
+            }
+        }
+    };
+
+    if (json.contains("vertices")) {
+        auto& vertices = json["vertices"];
+        if (vertices.is_array()) {
+            for (size_t i = 0; i < vertices.size(); i++)
+                read_vertex(i, vertices[i]);
+        } else if (vertices.is_object()) {
+            for (auto& p : vertices.items()) {
+                auto index = [&]() {
+                    try {
+                        return std::stoul(p.key());
+                    } catch (...) {
+                        hypergraph_error("keys in vertices object must be indexes");
+                    }
+                }();
+                read_vertex(index, p.value());
+            }
+        } else {
+            hypergraph_error("invalid vertices field");
+        }
+    }
+
+    for (auto& e : json["edges"]) {
+        if (!e.is_object() || !e.contains("vertices"))
+            hypergraph_error("edge missing list of vertices");
+
+        auto& verts = e["vertices"];
+        if (!verts.is_array())
+            hypergraph_error("edge[].vertices must be an array");
+
+        Hyperedge edge;
+        for (auto& v : verts) {
+            if (!v.is_number_unsigned())
+                hypergraph_error("edge[].vertices[] must be an index into the list of vertices");
+            auto index = v.get<size_t>();
+            edge.vertices.push_back(index);
+            if (res.vertices.size() < index + 1)
+                res.vertices.resize(index + 1);
+        }
+
+        for (auto& p : e.items()) {
+            if (p.key() != "vertices")
+                res.set_edge_style(res.edges.size(), p.key(), p.value());
+        }
+
+        res.edges.push_back(std::move(edge));
+    }
+
+    for (auto& p : json.items()) {
+        if (p.key() != "vertices" && p.key() != "edges")
+            res.options[p.key()] = p.value();
+    }
+
+    return res;
+}
+
+// Json objects of the vertices [first, first + count)
+static nlohmann::json vertex_objects(const Hypergraph& g, size_t first, size_t count) {
+    auto res = nlohmann::json::array();
+    for (auto i = first; i < first + count; i++) {
+        auto obj = nlohmann::json::object();
+        if (g.vertices[i].has_pos)
+            obj["pos"] = nlohmann::json::array({ g.vertices[i].pos.x, g.vertices[i].pos.y });
+        res.push_back(std::move(obj));
+    }
+    g.vertex_styles.write(g.strings, res, first);
+    return res;
+}
+
+// Json objects of the edges [first, first + count)
+static nlohmann::json edge_objects(const Hypergraph& g, size_t first, size_t count) {
+    auto res = nlohmann::json::array();
+    for (auto i = first; i < first + count; i++)
+        res.push_back({ { "vertices", g.edges[i].vertices } });
+    g.edge_styles.write(g.strings, res, first);
+    return res;
+}
+
+nlohmann::json hypergraph_to_json(const Hypergraph& g) {
+    auto res = g.options;
+    res["vertices"] = vertex_objects(g, 0, g.vertices.size());
+    res["edges"] = edge_objects(g, 0, g.edges.size());
+    return res;
+}
+
+void write_json_hypergraph(const Hypergraph& g, const std::function<void(std::string_view)>& write) {
+    // Every block costs a pass over the extras
+    constexpr size_t elements_per_block = 65536;
+
+    // Output is collected in a buffer and written in large blocks
+    std::string out;
+    auto flush = [&]() {
+        write(out);
+        out.clear();
+    };
+
+    auto write_elements = [&](size_t count, nlohmann::json (*objects)(const Hypergraph&, size_t, size_t)) {
+        out += '[';
+        for (size_t first = 0; first < count; first += elements_per_block) {
+            auto block = objects(g, first, std::min(elements_per_block, count - first));
+            for (size_t i = 0; i < block.size(); i++) {
+                if (first + i > 0)
+                    out += ',';
+                out += block[i].dump();
+                if (out.size() > 1 << 20)
+                    flush();
+            }
+        }
+        out += ']';
+    };
+
+    // Keys go in the sorted order of json objects so the text is the same as that of hypergraph_to_json
+    bool first_key = true;
+    auto write_key = [&](const std::string& key) {
+        out += first_key ? '{' : ',';
+        out += nlohmann::json(key).dump();
+        out += ':';
+        first_key = false;
+    };
+
+    bool edges_written = false;
+    bool vertices_written = false;
+    auto write_elements_before = [&](const std::string* key) {
+        if (!edges_written && (!key || *key > "edges")) {
+            write_key("edges");
+            write_elements(g.edges.size(), edge_objects);
+            edges_written = true;
+        }
+        if (!vertices_written && (!key || *key > "vertices")) {
+            write_key("vertices");
+            write_elements(g.vertices.size(), vertex_objects);
+            vertices_written = true;
+        }
+    };
+
+    for (auto& p : g.options.items()) {
+        if (p.key() == "vertices" || p.key() == "edges")
+            continue;
+        write_elements_before(&p.key());
+        write_key(p.key());
+        out += p.value().dump();
+    }
+    write_elements_before(nullptr);
+    out += '}';
+    flush();
+}
+
+Hypergraph hypergraph_from_binary(const BinaryHypergraph& binary) {
+    Hypergraph res;
+
+    res.vertices.resize(binary.vertex_count());
+    if (binary.positions) {
+        for (size_t i = 0; i < res.vertices.size(); i++) {
+            res.vertices[i].pos = { binary.positions[2 * i], binary.positions[2 * i + 1] };
+            res.vertices[i].has_pos = true;
+        }
+    }
+
+    res.edges.resize(binary.edge_count());
+    for (size_t e = 0; e < res.edges.size(); e++)
+        res.edges[e].vertices.assign(binary.edge_vertices + binary.edge_offsets[e], binary.edge_vertices + binary.edge_offsets[e + 1]);
+
+    for (size_t i = 0; i < binary.attribute_count(); i++) {
+        auto& a = binary.attributes[i];
+        std::string key = binary.string(a.key);
+        if (a.scope == BINARY_GLOBAL)
+            res.options[key] = binary.value(a);
+        else if (a.scope == BINARY_VERTEX)
+            res.set_vertex_style(a.index, key, binary.value(a));
+        else
+            res.set_edge_style(a.index, key, binary.value(a));
+    }
+
+    return res;
+}
+
+BinaryWriter hypergraph_to_binary(const Hypergraph& g) {
+    BinaryWriter writer;
+    writer.vertex_count = g.vertices.size();
+
+    for (auto& e : g.edges)
+        writer.add_edge(e.vertices);
+
+    if (std::all_of(g.vertices.begin(), g.vertices.end(), [](const Vertex& v) { return v.has_pos; })) {
+        for (auto& v : g.vertices) {
+            writer.positions.push_back(v.pos.x);
+            writer.positions.push_back(v.pos.y);
+        }
+    }
+
+    for (auto& p : g.options.items())
+        writer.add_attribute(BINARY_GLOBAL, 0, p.key(), p.value());
+    g.vertex_styles.visit(g.strings, [&](size_t i, std::string_view key, const nlohmann::json& val) { writer.add_attribute(BINARY_VERTEX, i, key, val); });
+    g.edge_styles.visit(g.strings, [&](size_t i, std::string_view key, const nlohmann::json& val) { writer.add_attribute(BINARY_EDGE, i, key, val); });
+
+    return writer;
+}
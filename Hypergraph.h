@@ -0,0 +1,204 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "BinaryFormat.h"
+#include "Vec2f.h"
+
+// Thrown for invalid input or options, the message is meant for the user
+struct HypergraphError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Throws a HypergraphError with a printf formatted message
+[[noreturn]] __attribute__((format(printf, 1, 2))) void hypergraph_error(const char* fmt, ...);
+
+// Distinct strings of the attributes of a hypergraph, each stored once and referred to by its index
+class StringPool {
+  public:
+    StringPool() = default;
+    StringPool(const StringPool& other) : strings(other.strings) { index(); }
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(const StringPool& other) {
+        strings = other.strings;
+        index();
+        return *this;
+    }
+    StringPool& operator=(StringPool&&) = default;
+
+    uint32_t intern(std::string_view str) {
+        if (auto it = ids.find(str); it != ids.end())
+            return it->second;
+        auto id = (uint32_t)strings.size();
+        ids.emplace(strings.emplace_back(str), id);
+        return id;
+    }
+
+    std::string_view get(uint32_t id) const { return strings[id]; }
+
+    size_t size() const { return strings.size(); }
+
+  private:
+    // A deque never moves its elements so the keys of ids stay valid
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    void index() {
+        ids.clear();
+        for (size_t i = 0; i < strings.size(); i++)
+            ids.emplace(strings[i], (uint32_t)i);
+    }
+};
+
+// Attributes of one vertex or hyperedge, only set when present in the input with the right type. Strings point into
+// the StringPool of the hypergraph.
+struct Style {
+    std::optional<double> radius;
+    std::optional<std::string_view> fill;
+    std::optional<double> fill_opacity;
+    std::optional<std::string_view> stroke;
+    std::optional<double> stroke_opacity;
+    std::optional<double> stroke_width;
+    std::optional<bool> convex_hull;
+    std::optional<std::string_view> label;
+};
+
+// Attributes of all vertices or all hyperedges of a hypergraph, one column per attribute and a bit per attribute
+// and element that says whether it is set. A column is only allocated once an element sets its attribute and only
+// reaches up to the last element that did, so elements without attributes cost at most one byte.
+// Keys that are not drawn, or drawn ones with a value of another type, are kept in a list of extras so they can be
+// written out again.
+struct StyleColumns {
+    enum : uint8_t {
+        RADIUS = 1 << 0,
+        FILL = 1 << 1,
+        FILL_OPACITY = 1 << 2,
+        STROKE = 1 << 3,
+        STROKE_OPACITY = 1 << 4,
+        STROKE_WIDTH = 1 << 5,
+        CONVEX_HULL = 1 << 6,
+        LABEL = 1 << 7,
+    };
+
+    std::vector<uint8_t> present;
+    std::vector<double> radius;
+    std::vector<double> fill_opacity;
+    std::vector<double> stroke_opacity;
+    std::vector<double> stroke_width;
+    std::vector<uint32_t> fill;
+    std::vector<uint32_t> stroke;
+    std::vector<uint32_t> label;
+    std::vector<uint8_t> convex_hull;
+
+    // Any other attribute, key is an index into the StringPool
+    struct Extra {
+        size_t element;
+        uint32_t key;
+        nlohmann::json value;
+    };
+    std::vector<Extra> extras;
+
+    bool has(size_t i, uint8_t attribute) const { return i < present.size() && (present[i] & attribute); }
+
+    // Sets the attribute for key of element i, into its column if val has the type it is drawn with and as an extra
+    // otherwise
+    void set(size_t i, const std::string& key, const nlohmann::json& val, StringPool& strings);
+
+    Style get(size_t i, const StringPool& strings) const;
+
+    // Calls f(element, key, value) for every attribute that is set, the columns first and then the extras in the order
+    // they were set
+    void visit(const StringPool& strings, const std::function<void(size_t, std::string_view, const nlohmann::json&)>& f) const;
+
+    // Adds the attributes of the elements [first, first + objects.size()) to their json objects in objects
+    void write(const StringPool& strings, nlohmann::json& objects, size_t first = 0) const;
+};
+
+struct Vertex {
+    Vec2f pos = {};
+    bool has_pos = false;
+};
+
+struct Hyperedge {
+    std::vector<size_t> vertices;
+};
+
+// In memory hypergraph shared by layout and drawing.
+// options holds the top level scalar options of the json format, such as "layout-engine" or "vertex-fill".
+struct Hypergraph {
+    nlohmann::json options = nlohmann::json::object();
+    std::vector<Vertex> vertices;
+    std::vector<Hyperedge> edges;
+
+    // Per element attributes such as "fill" or "label", indexed like vertices and edges
+    StyleColumns vertex_styles;
+    StyleColumns edge_styles;
+    StringPool strings;
+
+    Style vertex_style(size_t v) const { return vertex_styles.get(v, strings); }
+    Style edge_style(size_t e) const { return edge_styles.get(e, strings); }
+
+    void set_vertex_style(size_t v, const std::string& key, const nlohmann::json& val) { vertex_styles.set(v, key, val, strings); }
+    void set_edge_style(size_t e, const std::string& key, const nlohmann::json& val) { edge_styles.set(e, key, val, strings); }
+
+    void set_positions(const std::vector<Vec2f>& positions) {
+        for (size_t i = 0; i < vertices.size() && i < positions.size(); i++) {
+            vertices[i].pos = positions[i];
+            vertices[i].has_pos = true;
+        }
+    }
+
+    size_t incidence_count() const {
+        size_t res = 0;
+        for (auto& e : edges)
+            res += e.vertices.size();
+        return res;
+    }
+
+    size_t largest_edge() const {
+        size_t res = 0;
+        for (auto& e : edges)
+            res = std::max(res, e.vertices.size());
+        return res;
+    }
+
+    // Throws unless every edge only references existing vertices, and every vertex has a position if positions is set
+    void validate(bool positions) const;
+};
+
+// Streams a json hypergraph from file without building a document, every field other than the positions and
+// hyperedge vertices is kept as an option or attribute.
+// Vertices must all have positions when require_positions is set, otherwise vertices that are only referenced by
+// edges are created.
+Hypergraph read_json_hypergraph(FILE* file, bool require_positions);
+Hypergraph read_json_hypergraph(std::string_view text, bool require_positions);
+
+// Builds a hypergraph from an already parsed json document
+Hypergraph hypergraph_from_json(const nlohmann::json& json);
+
+// Json document for g in the input format, vertices without a position are written without "pos"
+nlohmann::json hypergraph_to_json(const Hypergraph& g);
+
+// Writes the same text as hypergraph_to_json(g).dump() to write in pieces, building the json of only a block of
+// elements at a time
+void write_json_hypergraph(const Hypergraph& g, const std::function<void(std::string_view)>& write);
+
+// Builds a hypergraph from a loaded binary file, copying the hyperedges, positions and options out of it
+Hypergraph hypergraph_from_binary(const BinaryHypergraph& binary);
+
+// Binary form of g, positions are only stored when every vertex has one. Options and attributes whose values are
+// arrays or objects have no representation in the format and are dropped.
+BinaryWriter hypergraph_to_binary(const Hypergraph& g);
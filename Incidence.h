@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+// Compressed incidence lists for a hypergraph, in both directions.
+// Members of edge e are edge_vertices[edge_offsets[e]..edge_offsets[e + 1]]
+// and the edges containing vertex v are vertex_edges[vertex_offsets[v]..vertex_offsets[v + 1]].
+struct Incidence {
+    size_t vertex_count = 0;
+    size_t edge_count = 0;
+
+    std::vector<size_t> edge_offsets;
+    std::vector<size_t> edge_vertices;
+
+    std::vector<size_t> vertex_offsets;
+    std::vector<size_t> vertex_edges;
+
+    size_t edge_size(size_t e) const { return edge_offsets[e + 1] - edge_offsets[e]; }
+    const size_t* edge_begin(size_t e) const { return edge_vertices.data() + edge_offsets[e]; }
+    const size_t* edge_end(size_t e) const { return edge_vertices.data() + edge_offsets[e + 1]; }
+
+    size_t vertex_degree(size_t v) const { return vertex_offsets[v + 1] - vertex_offsets[v]; }
+    const size_t* vertex_begin(size_t v) const { return vertex_edges.data() + vertex_offsets[v]; }
+    const size_t* vertex_end(size_t v) const { return vertex_edges.data() + vertex_offsets[v + 1]; }
+
+    // Edges is any container of objects with a `vertices` list of indexes below vertex_count
+    template <typename Edges>
+    static Incidence from_edges(size_t vertex_count, const Edges& edges) {
+        Incidence res;
+        res.vertex_count = vertex_count;
+        res.edge_count = edges.size();
+
+        res.edge_offsets.reserve(edges.size() + 1);
+        res.edge_offsets.push_back(0);
+        for (auto& e : edges) {
+            res.edge_vertices.insert(res.edge_vertices.end(), e.vertices.begin(), e.vertices.end());
+            res.edge_offsets.push_back(res.edge_vertices.size());
+        }
+
+        res.build_vertex_edges();
+        return res;
+    }
+
+    // Fills vertex_offsets and vertex_edges from the edge lists with a counting sort, edges stay in ascending order per vertex
+    void build_vertex_edges() {
+        vertex_offsets.assign(vertex_count + 1, 0);
+        for (auto v : edge_vertices)
+            vertex_offsets[v + 1]++;
+        for (size_t v = 0; v < vertex_count; v++)
+            vertex_offsets[v + 1] += vertex_offsets[v];
+
+        vertex_edges.resize(edge_vertices.size());
+        std::vector<size_t> fill(vertex_offsets.begin(), vertex_offsets.end() - 1);
+        for (size_t e = 0; e < edge_count; e++) {
+            for (auto i = edge_offsets[e]; i < edge_offsets[e + 1]; i++)
+                vertex_edges[fill[edge_vertices[i]]++] = e;
+        }
+    }
+};
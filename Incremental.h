@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ForceLayout.h"
+#include "Incidence.h"
+#include "Vec2f.h"
+
+// Where an incremental layout starts and which vertices it may move
+struct IncrementalStart {
+    std::vector<Vec2f> positions;
+    // Sorted
+    std::vector<size_t> active;
+    size_t new_vertices = 0;
+    size_t unbalanced_vertices = 0;
+};
+
+// Finds the part of a laid out hypergraph that changed since it was laid out.
+// Vertices without a position are new and start at the mean of their positioned neighbours, or next to the drawing
+// when they have none. In a settled layout the forces on every vertex nearly cancel out, adding or removing a
+// hyperedge leaves its vertices with a net force far above the rest. Vertices with more than imbalance times the
+// median force are unbalanced. New and unbalanced vertices and the vertices within hops hyperedges of them are
+// active, all others keep their position.
+inline IncrementalStart incremental_start(const Incidence& incidence, std::vector<Vec2f> positions, const std::vector<bool>& has_pos, const ForceLayoutOptions& force, double imbalance, size_t hops, ThreadPool* pool = nullptr) {
+    auto n = incidence.vertex_count;
+    auto edge_length = force.edge_length;
+
+    IncrementalStart res;
+    std::vector<char> active(n, 0);
+    std::vector<char> placed(has_pos.begin(), has_pos.end());
+    std::vector<size_t> unplaced;
+
+    for (size_t v = 0; v < n; v++) {
+        if (!placed[v]) {
+            unplaced.push_back(v);
+            active[v] = 1;
+        }
+    }
+    res.new_vertices = unplaced.size();
+
+    // New vertices are placed in rounds so the result does not depend on the order they are visited in. A little
+    // offset in a direction only depending on the vertex keeps vertices with the same neighbours apart.
+    std::vector<std::pair<size_t, Vec2f>> round;
+    while (!unplaced.empty()) {
+        round.clear();
+        for (auto v : unplaced) {
+            Vec2f sum = {};
+            size_t count = 0;
+            for (auto e = incidence.vertex_begin(v); e != incidence.vertex_end(v); e++) {
+                for (auto u = incidence.edge_begin(*e); u != incidence.edge_end(*e); u++) {
+                    if (placed[*u]) {
+                        sum += positions[*u];
+                        count++;
+                    }
+                }
+            }
+            if (count > 0)
+                round.emplace_back(v, sum / (double)count + Vec2f{ std::cos(v * 2.399963), std::sin(v * 2.399963) } * (edge_length / 2));
+        }
+
+        if (round.empty())
+            break;
+
+        for (auto [v, p] : round) {
+            positions[v] = p;
+            placed[v] = 1;
+        }
+        std::erase_if(unplaced, [&](size_t v) { return placed[v]; });
+    }
+
+    // Whatever is not connected to the drawing at all is laid out at random to its right
+    if (!unplaced.empty()) {
+        Vec2f min = { INFINITY, INFINITY };
+        Vec2f max = { -INFINITY, -INFINITY };
+        for (size_t v = 0; v < n; v++) {
+            if (!placed[v])
+                continue;
+            min.x = std::min(min.x, positions[v].x);
+            min.y = std::min(min.y, positions[v].y);
+            max.x = std::max(max.x, positions[v].x);
+            max.y = std::max(max.y, positions[v].y);
+        }
+        if (min.x > max.x)
+            min = max = {};
+
+        auto extra = random_positions(unplaced.size(), edge_length, force.seed);
+        auto half = edge_length * std::sqrt((double)unplaced.size()) / 2;
+        Vec2f offset = { max.x + edge_length + half, (min.y + max.y) / 2 };
+        for (size_t i = 0; i < unplaced.size(); i++)
+            positions[unplaced[i]] = extra[i] + offset;
+    }
+
+    // Forces are computed with every vertex in place, new ones included
+    ForceLayout layout(incidence, positions, force, pool);
+    auto forces = layout.forces();
+    auto sorted = forces;
+    if (!sorted.empty()) {
+        auto mid = sorted.begin() + sorted.size() / 2;
+        std::nth_element(sorted.begin(), mid, sorted.end());
+        auto limit = std::max(*mid, 1e-3 * force.edge_length) * imbalance;
+
+        for (size_t v = 0; v < n; v++) {
+            if (!active[v] && forces[v] > limit) {
+                res.unbalanced_vertices++;
+                active[v] = 1;
+            }
+        }
+    }
+
+    std::vector<size_t> frontier;
+    for (size_t v = 0; v < n; v++) {
+        if (active[v])
+            frontier.push_back(v);
+    }
+
+    for (size_t h = 0; h < hops && !frontier.empty(); h++) {
+        std::vector<size_t> next;
+        for (auto v : frontier) {
+            for (auto e = incidence.vertex_begin(v); e != incidence.vertex_end(v); e++) {
+                for (auto u = incidence.edge_begin(*e); u != incidence.edge_end(*e); u++) {
+                    if (!active[*u]) {
+                        active[*u] = 1;
+                        next.push_back(*u);
+                    }
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+
+    for (size_t v = 0; v < n; v++) {
+        if (active[v])
+            res.active.push_back(v);
+    }
+
+    res.positions = std::move(positions);
+    return res;
+}
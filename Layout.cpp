@@ -0,0 +1,541 @@
+#include "Layout.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#ifdef HAVE_GRAPHVIZ
+#include <gvc.h>
+#endif
+
+#include "Components.h"
+#include "Incidence.h"
+#include "Incremental.h"
+#include "LayoutCache.h"
+#include "Multilevel.h"
+#include "PivotMds.h"
+
+LayoutOptions LayoutOptions::from_json(const nlohmann::json& json) {
+    LayoutOptions options;
+
+    if (json.contains("layout-engine") && json["layout-engine"].is_string())
+        options.engine = json["layout-engine"];
+
+    if (json.contains("expansion") && json["expansion"].is_string())
+        options.expansion = json["expansion"];
+
+    if (json.contains("expansion-max-clique") && json["expansion-max-clique"].is_number_unsigned())
+        options.expansion_max_clique = json["expansion-max-clique"].get<size_t>();
+
+    if (json.contains("expansion-weight") && json["expansion-weight"].is_string())
+        options.expansion_weight = json["expansion-weight"];
+
+    if (json.contains("layout-iterations") && json["layout-iterations"].is_number_unsigned())
+        options.force.iterations = json["layout-iterations"].get<size_t>();
+
+    if (json.contains("layout-seed") && json["layout-seed"].is_number_unsigned())
+        options.force.seed = json["layout-seed"].get<uint64_t>();
+
+    if (json.contains("layout-edge-length") && json["layout-edge-length"].is_number())
+        options.force.edge_length = json["layout-edge-length"].get<double>();
+
+    if (json.contains("layout-theta") && json["layout-theta"].is_number())
+        options.force.theta = json["layout-theta"].get<double>();
+
+    if (json.contains("layout-gravity") && json["layout-gravity"].is_number())
+        options.force.gravity = json["layout-gravity"].get<double>();
+
+    if (json.contains("layout-multilevel") && json["layout-multilevel"].is_boolean())
+        options.multilevel = json["layout-multilevel"].get<bool>();
+
+    if (json.contains("layout-pivots") && json["layout-pivots"].is_number_unsigned())
+        options.pivots = json["layout-pivots"].get<size_t>();
+
+    if (json.contains("layout-stress-iterations") && json["layout-stress-iterations"].is_number_unsigned())
+        options.stress_iterations = json["layout-stress-iterations"].get<size_t>();
+
+    if (json.contains("layout-components") && json["layout-components"].is_boolean())
+        options.components = json["layout-components"].get<bool>();
+
+    if (json.contains("layout-incremental") && json["layout-incremental"].is_boolean())
+        options.incremental = json["layout-incremental"].get<bool>();
+
+    if (json.contains("layout-incremental-imbalance") && json["layout-incremental-imbalance"].is_number())
+        options.incremental_imbalance = json["layout-incremental-imbalance"].get<double>();
+
+    if (json.contains("layout-incremental-hops") && json["layout-incremental-hops"].is_number_unsigned())
+        options.incremental_hops = json["layout-incremental-hops"].get<size_t>();
+
+    if (json.contains("layout-threads") && json["layout-threads"].is_number_unsigned())
+        options.threads = json["layout-threads"].get<size_t>();
+
+    if (json.contains("layout-time-budget-ms") && json["layout-time-budget-ms"].is_number())
+        options.time_budget_ms = json["layout-time-budget-ms"].get<double>();
+
+    return options;
+}
+
+// An incremental layout needs at least one vertex that already has a position
+static bool is_incremental(const Hypergraph& g, const LayoutOptions& options) {
+    return options.incremental && std::any_of(g.vertices.begin(), g.vertices.end(), [](const Vertex& v) { return v.has_pos; });
+}
+
+static IncrementalStart find_changes(const Hypergraph& g, const Incidence& incidence, const LayoutOptions& options, ThreadPool* pool, Stats* stats) {
+    if (options.incremental_imbalance <= 0)
+        hypergraph_error("layout-incremental-imbalance must be positive");
+
+    StatsTimer timer(stats, "find-changes");
+
+    std::vector<Vec2f> positions(g.vertices.size());
+    std::vector<bool> has_pos(g.vertices.size());
+    for (size_t i = 0; i < g.vertices.size(); i++) {
+        positions[i] = g.vertices[i].pos;
+        has_pos[i] = g.vertices[i].has_pos;
+    }
+
+    auto start = incremental_start(incidence, std::move(positions), has_pos, options.force, options.incremental_imbalance, options.incremental_hops, pool);
+
+    if (stats) {
+        stats->set("new-vertices", start.new_vertices);
+        stats->set("unbalanced-vertices", start.unbalanced_vertices);
+        stats->set("active-vertices", start.active.size());
+    }
+    return start;
+}
+
+static std::vector<Vec2f> native_layout(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool, Stats* stats, LayoutProgress& progress) {
+    if (options.force.edge_length <= 0)
+        hypergraph_error("layout-edge-length must be positive");
+
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!pool) {
+        own_pool = std::make_unique<ThreadPool>(options.threads ? options.threads : std::thread::hardware_concurrency());
+        pool = own_pool.get();
+    }
+
+    Incidence incidence;
+    {
+        StatsTimer timer(stats, "incidence");
+        incidence = Incidence::from_edges(g.vertices.size(), g.edges);
+    }
+
+    if (is_incremental(g, options)) {
+        auto start = find_changes(g, incidence, options, pool, stats);
+
+        StatsTimer timer(stats, "force-layout");
+        if (!start.active.empty()) {
+            // Moves start small so the rest of the drawing stays where it was
+            auto force = options.force;
+            if (force.temperature <= 0)
+                force.temperature = force.edge_length;
+
+            ForceLayout layout(incidence, start.positions, force, pool);
+            layout.active = std::move(start.active);
+            layout.run(&progress);
+            progress.energy += layout.energy;
+        }
+        return start.positions;
+    }
+
+    StatsTimer timer(stats, "force-layout");
+
+    if (options.multilevel)
+        return multilevel_layout(incidence, options.force, pool, &progress);
+
+    auto positions = random_positions(g.vertices.size(), options.force.edge_length, options.force.seed);
+    ForceLayout layout(incidence, positions, options.force, pool);
+    layout.run(&progress);
+    progress.energy += layout.energy;
+    return positions;
+}
+
+static std::vector<Vec2f> pivot_layout(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool, Stats* stats, LayoutProgress& progress) {
+    if (options.force.edge_length <= 0)
+        hypergraph_error("layout-edge-length must be positive");
+
+    if (options.pivots < 2)
+        hypergraph_error("layout-pivots must be at least 2");
+
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!pool) {
+        own_pool = std::make_unique<ThreadPool>(options.threads ? options.threads : std::thread::hardware_concurrency());
+        pool = own_pool.get();
+    }
+
+    Incidence incidence;
+    {
+        StatsTimer timer(stats, "incidence");
+        incidence = Incidence::from_edges(g.vertices.size(), g.edges);
+    }
+
+    StatsTimer timer(stats, "pivot-mds");
+    PivotMdsOptions pivot_options;
+    pivot_options.pivots = options.pivots;
+    pivot_options.stress_iterations = options.stress_iterations;
+    pivot_options.edge_length = options.force.edge_length;
+    pivot_options.seed = options.force.seed;
+    pivot_options.deadline = options.force.deadline;
+    return pivot_mds_layout(incidence, pivot_options, pool, &progress);
+}
+
+Expansion expand_hypergraph(const Hypergraph& g, const LayoutOptions& options) {
+    if (options.expansion != "clique" && options.expansion != "star")
+        hypergraph_error("expansion must be either \"clique\" or \"star\"");
+
+    if (options.expansion_weight != "count" && options.expansion_weight != "size")
+        hypergraph_error("expansion-weight must be either \"count\" or \"size\"");
+
+    if (options.expansion_max_clique < 3)
+        hypergraph_error("expansion-max-clique must be at least 3");
+
+    bool by_size = options.expansion_weight == "size";
+    auto n = g.vertices.size();
+
+    Expansion res;
+    res.node_count = n;
+
+    // Index in res.edges of every pair of vertices, keyed by the smaller index times n plus the larger
+    std::unordered_map<uint64_t, size_t> pairs;
+    auto add_pair = [&](size_t a, size_t b, double weight) {
+        if (a == b)
+            return;
+        if (a > b)
+            std::swap(a, b);
+        auto [it, inserted] = pairs.try_emplace((uint64_t)a * n + b, res.edges.size());
+        if (inserted) {
+            res.edges.emplace_back(a, b);
+            res.weights.push_back(weight);
+        } else {
+            res.weights[it->second] += weight;
+        }
+    };
+
+    for (auto& e : g.edges) {
+        auto k = e.vertices.size();
+        if (options.expansion == "star" && k > 2) {
+            // The center is new so none of its edges are shared
+            auto center = res.node_count++;
+            for (auto v : e.vertices) {
+                res.edges.emplace_back(center, v);
+                res.weights.push_back(1);
+            }
+            continue;
+        }
+
+        auto weight = by_size && k > 1 ? 1.0 / (k - 1) : 1.0;
+        if (k <= options.expansion_max_clique) {
+            // Create a complete graph with the edges
+            for (size_t i = k; i-- > 1;) {
+                for (size_t j = 0; j < i; j++)
+                    add_pair(e.vertices[i], e.vertices[j], weight);
+            }
+        } else {
+            res.sparsified++;
+            for (size_t step = 1; step <= k / 2; step *= 2) {
+                for (size_t i = 0; i < k; i++) {
+                    // Halfway around the ring both ends would add the same pair
+                    if (2 * step == k && i >= step)
+                        break;
+                    add_pair(e.vertices[i], e.vertices[(i + step) % k], weight);
+                }
+            }
+        }
+    }
+
+    return res;
+}
+
+#ifdef HAVE_GRAPHVIZ
+// Creating a context loads every graphviz plugin, so one context is made on first use and kept for all layouts.
+// Graphviz is not thread safe, layouts hold graphviz_mutex while they use it.
+static std::mutex graphviz_mutex;
+
+static GVC_t* graphviz_context() {
+    static GVC_t* gvc = gvContext();
+    return gvc;
+}
+
+static std::vector<Vec2f> graphviz_layout(const Hypergraph& g, const LayoutOptions& options, Stats* stats) {
+    Expansion expansion;
+    {
+        StatsTimer timer(stats, "expansion");
+        expansion = expand_hypergraph(g, options);
+    }
+
+    if (stats) {
+        stats->set("expanded-nodes", expansion.node_count);
+        stats->set("expanded-edges", expansion.edges.size());
+        stats->set("sparsified-edges", expansion.sparsified);
+    }
+
+    std::optional<IncrementalStart> start;
+    if (is_incremental(g, options))
+        start = find_changes(g, Incidence::from_edges(g.vertices.size(), g.edges), options, nullptr, stats);
+
+    std::lock_guard lock(graphviz_mutex);
+    auto gvc = graphviz_context();
+
+    std::optional<StatsTimer> timer;
+    timer.emplace(stats, "graphviz-graph");
+
+    Agraph_t* graph = agopen(0, Agundirected, 0);
+
+    // Dummy nodes come after the vertices so they are not output
+    std::vector<Agnode_t*> nodes;
+    for (size_t i = 0; i < expansion.node_count; i++)
+        nodes.push_back(agnode(graph, 0, 1));
+
+    // Only edges that stand in for more than one hyperedge, or a large one, need their weight set
+    char weight_attr[] = "weight";
+    Agsym_t* weight_sym = nullptr;
+    char weight[32];
+    for (size_t i = 0; i < expansion.edges.size(); i++) {
+        auto [a, b] = expansion.edges[i];
+        auto edge = agedge(graph, nodes[a], nodes[b], 0, 1);
+        if (expansion.weights[i] != 1) {
+            if (!weight_sym)
+                weight_sym = agattr(graph, AGEDGE, weight_attr, "1");
+            snprintf(weight, sizeof(weight), "%g", expansion.weights[i]);
+            agxset(edge, weight_sym, weight);
+        }
+    }
+
+    // neato and fdp start from pos and keep pinned nodes in place, other engines ignore both
+    if (start) {
+        char pos_attr[] = "pos";
+        char pin_attr[] = "pin";
+        char scale_attr[] = "inputscale";
+        char translate_attr[] = "notranslate";
+
+        // Positions are read in points, the unit graphviz writes them in, and not moved afterwards
+        agsafeset(graph, scale_attr, "72", "");
+        agsafeset(graph, translate_attr, "true", "");
+
+        std::vector<bool> active(g.vertices.size(), false);
+        for (auto v : start->active)
+            active[v] = true;
+
+        for (size_t i = 0; i < g.vertices.size(); i++) {
+            auto pos = std::to_string(start->positions[i].x) + "," + std::to_string(start->positions[i].y);
+            agsafeset(nodes[i], pos_attr, pos.c_str(), "");
+            if (!active[i])
+                agsafeset(nodes[i], pin_attr, "true", "false");
+        }
+    }
+
+    timer.emplace(stats, "gvLayout");
+    gvLayout(gvc, graph, options.engine.c_str());
+
+    timer.emplace(stats, "gvRender");
+    gvRender(gvc, graph, "dot", 0);
+
+    timer.emplace(stats, "positions");
+    auto pos_str = strdup("pos");
+
+    std::vector<Vec2f> positions;
+    for (size_t i = 0; i < g.vertices.size(); i++) {
+        auto pos_string = std::string(agget(nodes[i], pos_str));
+        double x = std::stof(pos_string.substr(0, pos_string.find_first_of(",")));
+        double y = std::stof(pos_string.substr(pos_string.find_first_of(",") + 1));
+        positions.push_back({ x, y });
+    }
+
+    free(pos_str);
+
+    timer.emplace(stats, "graphviz-free");
+    gvFreeLayout(gvc, graph);
+    agclose(graph);
+
+    return positions;
+}
+#endif
+
+// Lays out g as a whole with the engine of options, the native engines add how far they got to progress
+static std::vector<Vec2f> layout_connected(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool, Stats* stats, LayoutProgress& progress) {
+    // An embedding from scratch would throw the existing positions away, changes are relaxed with the forces instead
+    if (options.engine == "native-fdp" || (options.engine == "pivot-mds" && is_incremental(g, options)))
+        return native_layout(g, options, pool, stats, progress);
+
+    if (options.engine == "pivot-mds")
+        return pivot_layout(g, options, pool, stats, progress);
+
+#ifdef HAVE_GRAPHVIZ
+    return graphviz_layout(g, options, stats);
+#else
+    hypergraph_error("layout-engine '%s' needs graphviz which this build does not include, use native-fdp", options.engine.c_str());
+#endif
+}
+
+// Components with fewer vertices are laid out in parallel with each other on one thread each, bigger ones one after
+// the other on every thread
+static constexpr size_t parallel_component_vertices = 1024;
+
+// Lays out component c as a hypergraph of its own, local is the index of every vertex within its component
+static std::vector<Vec2f> layout_component(const Hypergraph& g, const Components& components, const std::vector<size_t>& local, size_t c, const LayoutOptions& options, ThreadPool* pool, LayoutProgress& progress) {
+    Hypergraph sub;
+    sub.vertices.resize(components.vertex_count(c));
+    for (auto i = components.edge_starts[c]; i < components.edge_starts[c + 1]; i++) {
+        auto& e = sub.edges.emplace_back();
+        for (auto v : g.edges[components.edges[i]].vertices)
+            e.vertices.push_back(local[v]);
+    }
+    return layout_connected(sub, options, pool, nullptr, progress);
+}
+
+static std::vector<Vec2f> layout_components(const Hypergraph& g, const Components& components, const LayoutOptions& options, ThreadPool* pool, Stats* stats, LayoutProgress& progress) {
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!pool) {
+        own_pool = std::make_unique<ThreadPool>(options.threads ? options.threads : std::thread::hardware_concurrency());
+        pool = own_pool.get();
+    }
+
+    std::optional<StatsTimer> timer;
+    timer.emplace(stats, "component-layout");
+
+    std::vector<size_t> local(g.vertices.size());
+    for (size_t c = 0; c < components.count; c++) {
+        for (auto i = components.vertex_starts[c]; i < components.vertex_starts[c + 1]; i++)
+            local[components.vertices[i]] = i - components.vertex_starts[c];
+    }
+
+    // One progress per component so that parallel layouts do not share it, added up in order afterwards
+    std::vector<std::vector<Vec2f>> layouts(components.count);
+    std::vector<LayoutProgress> progresses(components.count);
+    std::vector<size_t> small;
+    std::vector<size_t> large;
+    for (size_t c = 0; c < components.count; c++) {
+        if (components.vertex_count(c) == 1)
+            layouts[c] = { Vec2f{} };
+        else if (components.vertex_count(c) < parallel_component_vertices)
+            small.push_back(c);
+        else
+            large.push_back(c);
+    }
+
+    // The pool does not pass exceptions on, the first one is thrown again once every component is done
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    pool->parallel_for(small.size(), 1, [&](size_t begin, size_t end) {
+        ThreadPool serial(1);
+        for (auto i = begin; i < end; i++) {
+            try {
+                layouts[small[i]] = layout_component(g, components, local, small[i], options, &serial, progresses[small[i]]);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    });
+    if (error)
+        std::rethrow_exception(error);
+
+    // Small components are quick to finish, so with a time budget they come first and the rest goes to the large ones
+    for (auto c : large)
+        layouts[c] = layout_component(g, components, local, c, options, pool, progresses[c]);
+
+    for (auto& p : progresses)
+        progress.add(p);
+
+    timer.emplace(stats, "pack");
+
+    std::vector<Vec2f> mins(components.count);
+    std::vector<Vec2f> sizes(components.count);
+    for (size_t c = 0; c < components.count; c++) {
+        Vec2f min = { INFINITY, INFINITY };
+        Vec2f max = { -INFINITY, -INFINITY };
+        for (auto p : layouts[c]) {
+            min.x = std::min(min.x, p.x);
+            min.y = std::min(min.y, p.y);
+            max.x = std::max(max.x, p.x);
+            max.y = std::max(max.y, p.y);
+        }
+        mins[c] = min;
+        sizes[c] = max - min;
+    }
+
+    auto corners = pack_rectangles(sizes, options.force.edge_length);
+
+    std::vector<Vec2f> positions(g.vertices.size());
+    for (size_t c = 0; c < components.count; c++) {
+        for (auto i = components.vertex_starts[c]; i < components.vertex_starts[c + 1]; i++)
+            positions[components.vertices[i]] = layouts[c][i - components.vertex_starts[c]] - mins[c] + corners[c];
+    }
+    return positions;
+}
+
+static std::vector<Vec2f> compute_layout(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool, Stats* stats, LayoutProgress& progress) {
+    // Incremental layouts keep the components where they are, frames need every vertex in its final place from the
+    // start which packing the components only gives at the end
+    if (options.split_components() && !is_incremental(g, options) && !progress.on_frame) {
+        Components components;
+        {
+            StatsTimer timer(stats, "components");
+            components = connected_components(g);
+        }
+        if (stats)
+            stats->set("components", components.count);
+
+        if (components.count > 1)
+            return layout_components(g, components, options, pool, stats, progress);
+    }
+
+    return layout_connected(g, options, pool, stats, progress);
+}
+
+std::vector<Vec2f> layout_hypergraph(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool, Stats* stats) {
+    g.validate(false);
+
+    if (!(options.time_budget_ms >= 0))
+        hypergraph_error("layout-time-budget-ms must not be negative");
+
+    // The budget starts now and covers everything below, the engines only see when it ends. Budgets of centuries are
+    // capped so that the deadline can not overflow.
+    auto timed = options;
+    if (options.time_budget_ms > 0) {
+        std::chrono::duration<double, std::milli> budget(std::min(options.time_budget_ms, 1e12));
+        timed.force.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+    }
+
+    // Incremental layouts depend on the positions they start from so they are never cached
+    std::string cache_key;
+    if (!options.cache_dir.empty() && !is_incremental(g, options)) {
+        StatsTimer timer(stats, "cache-read");
+        cache_key = layout_cache_key(g, options);
+        auto cached = read_cached_layout(options.cache_dir, cache_key, g.vertices.size());
+        if (stats)
+            stats->set("cache-hit", cached.has_value());
+        if (cached)
+            return *cached;
+    }
+
+    LayoutProgress progress;
+    progress.on_frame = options.on_frame;
+    progress.frame_iterations = options.frame_iterations;
+    progress.frame_ms = options.frame_ms;
+    auto positions = compute_layout(g, timed, pool, stats, progress);
+
+    if (stats && (options.engine == "native-fdp" || options.engine == "pivot-mds")) {
+        stats->set("layout-iterations", progress.iterations);
+        stats->set("out-of-time", progress.out_of_time);
+        stats->set_value("layout-energy", progress.energy);
+    }
+
+    // Another run with more time would give different positions
+    if (!cache_key.empty() && !progress.out_of_time) {
+        StatsTimer timer(stats, "cache-write");
+        if (!write_cached_layout(options.cache_dir, cache_key, positions)) {
+            fprintf(stderr, "warning: could not write to layout cache '%s'\n", options.cache_dir.c_str());
+            if (stats)
+                stats->set("cache-write-failed", true);
+        }
+    }
+    return positions;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "ForceLayout.h"
+#include "Hypergraph.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "Vec2f.h"
+
+struct LayoutOptions {
+#ifdef HAVE_GRAPHVIZ
+    std::string engine = "neato";
+#else
+    std::string engine = "native-fdp";
+#endif
+    // How graphviz engines turn hyperedges into graph edges, "clique" or "star"
+    std::string expansion = "clique";
+    // Hyperedges with more vertices are expanded to a ring with chords instead of a clique
+    size_t expansion_max_clique = 64;
+    // Weight of a graph edge, "count" for the number of hyperedges it stands in for, "size" for the sum of
+    // 1 / (k - 1) over them for hyperedges of k vertices
+    std::string expansion_weight = "count";
+    ForceLayoutOptions force;
+    bool multilevel = false;
+    // Pivots and stress sweeps of the pivot-mds engine
+    size_t pivots = 50;
+    size_t stress_iterations = 20;
+    // Lay out every connected component on its own and pack the results side by side. Unset it is only done for the
+    // native engines and graphviz engines get the whole graph in one piece
+    std::optional<bool> components;
+    // 0 uses every hardware thread
+    size_t threads = 0;
+    // Wall clock time after which native-fdp and pivot-mds stop iterating and return what they have, 0 for no limit.
+    // Graphviz engines can not be interrupted and ignore it.
+    double time_budget_ms = 0;
+
+    // Called with the positions so far every frame_iterations iterations or frame_ms milliseconds while native-fdp or
+    // pivot-mds run, see LayoutProgress. Components are laid out together while it is set. Like cache_dir it is
+    // only set from code, never from the json.
+    std::function<void(const std::vector<Vec2f>&)> on_frame;
+    size_t frame_iterations = 0;
+    double frame_ms = 0;
+
+    // Directory of the layout cache, see LayoutCache.h, empty to always lay out. Not read from the json so that a
+    // document can not choose where files are written.
+    std::string cache_dir;
+
+    // Start from the positions the vertices already have and only move the part of the hypergraph that changed,
+    // see incremental_start
+    bool incremental = false;
+    double incremental_imbalance = 20;
+    size_t incremental_hops = 1;
+
+    bool split_components() const { return components.value_or(engine == "native-fdp" || engine == "pivot-mds"); }
+
+    // Reads the layout-* options of the json format, missing options keep their defaults
+    static LayoutOptions from_json(const nlohmann::json& options);
+};
+
+// Graph that stands in for a hypergraph in engines that only lay out graphs. Vertices keep their index, the dummy
+// nodes of star expansion are numbered after them. Every pair of nodes has at most one edge.
+struct Expansion {
+    size_t node_count = 0;
+    std::vector<std::pair<size_t, size_t>> edges;
+    std::vector<double> weights;
+    // Hyperedges above options.expansion_max_clique
+    size_t sparsified = 0;
+};
+
+// Replaces every hyperedge by a clique on its vertices, or for "star" hyperedges of more than 2 vertices by a
+// dummy node connected to each of them. A clique above options.expansion_max_clique vertices is replaced by a ring
+// with chords to the vertices 2, 4, 8... places further along, which keeps every vertex within a logarithmic number
+// of steps of the others with k log k edges. Pairs shared by several hyperedges get one edge whose weight adds up.
+Expansion expand_hypergraph(const Hypergraph& g, const LayoutOptions& options);
+
+// Computes a position for every vertex of g. Positions g already has are ignored unless options.incremental is set.
+// With options.split_components() the connected components are laid out separately, in parallel when they are small, and
+// packed into rows. With options.cache_dir set a cached layout is returned when there is one and stored otherwise.
+// The native engine runs on pool, or on a pool of options.threads threads when pool is null.
+// The time of each phase and the size of the expansion are recorded in stats when it is set, for native-fdp and
+// pivot-mds also the counters layout-iterations and out-of-time and the value layout-energy, see LayoutProgress.
+// A layout that ran out of time is not cached.
+std::vector<Vec2f> layout_hypergraph(const Hypergraph& g, const LayoutOptions& options, ThreadPool* pool = nullptr, Stats* stats = nullptr);
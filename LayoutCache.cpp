@@ -0,0 +1,138 @@
+#include "LayoutCache.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+namespace {
+
+// Part of every key, bump it when a change to an engine changes the positions it computes
+constexpr uint64_t layout_cache_version = 1;
+
+constexpr char entry_magic[4] = { 'H', 'G', 'L', 'C' };
+
+struct Fnv128 {
+    unsigned __int128 state = ((unsigned __int128)0x6c62272e07bb0142 << 64) | 0x62b821756295c58d;
+
+    void add(const void* data, size_t size) {
+        constexpr unsigned __int128 prime = ((unsigned __int128)1 << 88) | 0x13b;
+        auto bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) {
+            state ^= bytes[i];
+            state *= prime;
+        }
+    }
+
+    void add(uint64_t value) { add(&value, sizeof(value)); }
+    void add(double value) { add(&value, sizeof(value)); }
+
+    // Length first so that consecutive strings can not run into each other
+    void add(const std::string& str) {
+        add((uint64_t)str.size());
+        add(str.data(), str.size());
+    }
+};
+
+std::filesystem::path entry_path(const std::string& dir, const std::string& key) { return std::filesystem::path(dir) / (key + ".layout"); }
+
+} // namespace
+
+std::string layout_cache_key(const Hypergraph& g, const LayoutOptions& options) {
+    Fnv128 hash;
+    hash.add(layout_cache_version);
+
+    hash.add(options.engine);
+    hash.add(options.expansion);
+    hash.add((uint64_t)options.expansion_max_clique);
+    hash.add(options.expansion_weight);
+    hash.add((uint64_t)options.force.iterations);
+    hash.add(options.force.seed);
+    hash.add(options.force.edge_length);
+    hash.add(options.force.theta);
+    hash.add(options.force.gravity);
+    hash.add(options.force.temperature);
+    hash.add((uint64_t)options.multilevel);
+    hash.add((uint64_t)options.pivots);
+    hash.add((uint64_t)options.stress_iterations);
+    hash.add((uint64_t)options.split_components());
+
+    hash.add((uint64_t)g.vertices.size());
+    hash.add((uint64_t)g.edges.size());
+    for (auto& e : g.edges) {
+        hash.add((uint64_t)e.vertices.size());
+        for (auto v : e.vertices)
+            hash.add((uint64_t)v);
+    }
+
+    char hex[33];
+    snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)(hash.state >> 64), (unsigned long long)hash.state);
+    return hex;
+}
+
+std::optional<std::vector<Vec2f>> read_cached_layout(const std::string& dir, const std::string& key, size_t vertex_count) {
+    auto path = entry_path(dir, key);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return std::nullopt;
+
+    char magic[4];
+    uint64_t count = 0;
+    std::vector<Vec2f> positions;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, entry_magic, sizeof(magic)) == 0 && fread(&count, sizeof(count), 1, file) == 1 && count == vertex_count;
+    if (ok) {
+        positions.resize(count);
+        for (auto& p : positions) {
+            double xy[2];
+            if (fread(xy, sizeof(double), 2, file) != 2) {
+                ok = false;
+                break;
+            }
+            p = { xy[0], xy[1] };
+        }
+    }
+    fclose(file);
+
+    if (!ok)
+        return std::nullopt;
+    return positions;
+}
+
+bool write_cached_layout(const std::string& dir, const std::string& key, const std::vector<Vec2f>& positions) {
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error)
+        return false;
+
+    // Unique per process and thread so concurrent writers of the same entry do not share a temporary file
+    auto path = entry_path(dir, key);
+    auto temp_path = path;
+    temp_path += "." + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    uint64_t count = positions.size();
+    bool ok = fwrite(entry_magic, 1, sizeof(entry_magic), file) == sizeof(entry_magic) && fwrite(&count, sizeof(count), 1, file) == 1;
+    for (size_t i = 0; ok && i < positions.size(); i++) {
+        double xy[2] = { positions[i].x, positions[i].y };
+        ok = fwrite(xy, sizeof(double), 2, file) == 2;
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Hypergraph.h"
+#include "Layout.h"
+#include "Vec2f.h"
+
+// On disk cache of finished layouts, one file per layout named after its key.
+// A key covers everything the positions depend on: the vertex count, the vertices of every hyperedge in order and
+// every layout option except the thread count, which never changes the result, and the time budget, since layouts
+// that run out of time are not stored. Styles and other attributes are not
+// part of it, so a hypergraph that is only restyled reuses its layout.
+
+// 128 bit FNV-1a hash of the topology and options as 32 hex digits
+std::string layout_cache_key(const Hypergraph& g, const LayoutOptions& options);
+
+// Positions stored under key in dir, nothing when there is no entry or it does not have vertex_count positions
+std::optional<std::vector<Vec2f>> read_cached_layout(const std::string& dir, const std::string& key, size_t vertex_count);
+
+// Stores positions under key in dir, creating dir when needed. The entry is written to a temporary file and renamed
+// into place so concurrent readers and writers never see a partial entry. A cache that can not be written is not an
+// error for the layout, false is returned and the positions are only not stored.
+bool write_cached_layout(const std::string& dir, const std::string& key, const std::vector<Vec2f>& positions);
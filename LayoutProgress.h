@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "Vec2f.h"
+
+// Time after which the iterative engines stop and keep the positions they have reached
+using Deadline = std::chrono::steady_clock::time_point;
+
+static constexpr Deadline no_deadline = Deadline::max();
+
+inline bool past_deadline(Deadline deadline) { return deadline != no_deadline && std::chrono::steady_clock::now() >= deadline; }
+
+// How far the iterative engines got. Every run adds to it, e.g. each level of a multilevel layout and each component.
+struct LayoutProgress {
+    size_t iterations = 0;
+    // Some run was stopped by its deadline before it finished its iterations
+    bool out_of_time = false;
+    // Sum of the squared net forces for native-fdp, or the sparse stress for pivot-mds, at the start of the last
+    // iteration. Runs that did no iteration add nothing.
+    double energy = 0;
+
+    // Receives the positions of every vertex while the layout is still running, after every frame_iterations
+    // iterations or once frame_ms milliseconds have passed since the last frame, whichever comes first
+    std::function<void(const std::vector<Vec2f>&)> on_frame;
+    size_t frame_iterations = 0;
+    double frame_ms = 0;
+
+    // Counts an iteration towards the next frame and says whether it is due
+    bool frame_due() {
+        if (!on_frame)
+            return false;
+
+        auto now = std::chrono::steady_clock::now();
+        iterations_since_frame++;
+        if ((frame_iterations > 0 && iterations_since_frame >= frame_iterations) || (frame_ms > 0 && std::chrono::duration<double, std::milli>(now - last_frame).count() >= frame_ms)) {
+            iterations_since_frame = 0;
+            last_frame = now;
+            return true;
+        }
+        return false;
+    }
+
+    // Adds the counts of other, not its frames
+    void add(const LayoutProgress& other) {
+        iterations += other.iterations;
+        out_of_time = out_of_time || other.out_of_time;
+        energy += other.energy;
+    }
+
+  private:
+    size_t iterations_since_frame = 0;
+    std::chrono::steady_clock::time_point last_frame = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "ForceLayout.h"
+#include "Incidence.h"
+#include "ThreadPool.h"
+#include "Vec2f.h"
+
+// A coarser copy of a hypergraph, parent maps every vertex of the finer level to the vertex it was contracted into
+struct CoarseLevel {
+    Incidence incidence;
+    std::vector<double> masses;
+    std::vector<size_t> parent;
+};
+
+// Hyperedges bigger than this do not count towards how strongly two vertices are connected, they say very
+// little about any single pair and rating them would be quadratic in their size.
+static constexpr size_t coarsen_max_rated_edge_size = 64;
+
+// Contracts pairs of vertices that share heavy hyperedges, a hyperedge of size k adds 1 / (k - 1) to the rating of
+// every pair in it. Vertices are visited in a random order from seed and matched with their best unmatched neighbour,
+// preferring light neighbours so that the masses stay balanced.
+inline CoarseLevel coarsen(const Incidence& fine, const std::vector<double>& masses, uint64_t seed) {
+    auto n = fine.vertex_count;
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(seed));
+
+    constexpr size_t unmatched = SIZE_MAX;
+
+    CoarseLevel res;
+    res.parent.assign(n, unmatched);
+
+    std::vector<double> rating(n, 0);
+    std::vector<size_t> touched;
+
+    size_t coarse_count = 0;
+
+    for (auto v : order) {
+        if (res.parent[v] != unmatched)
+            continue;
+
+        for (auto e = fine.vertex_begin(v); e != fine.vertex_end(v); e++) {
+            auto size = fine.edge_size(*e);
+            if (size < 2 || size > coarsen_max_rated_edge_size)
+                continue;
+
+            for (auto u = fine.edge_begin(*e); u != fine.edge_end(*e); u++) {
+                if (*u == v || res.parent[*u] != unmatched)
+                    continue;
+                if (rating[*u] == 0)
+                    touched.push_back(*u);
+                rating[*u] += 1.0 / (double)(size - 1);
+            }
+        }
+
+        size_t best = unmatched;
+        double best_score = 0;
+        for (auto u : touched) {
+            auto score = rating[u] / masses[u];
+            if (score > best_score || (score == best_score && u < best)) {
+                best = u;
+                best_score = score;
+            }
+            rating[u] = 0;
+        }
+        touched.clear();
+
+        res.parent[v] = coarse_count;
+        res.masses.push_back(masses[v]);
+
+        if (best != unmatched) {
+            res.parent[best] = coarse_count;
+            res.masses.back() += masses[best];
+        }
+
+        coarse_count++;
+    }
+
+    auto& coarse = res.incidence;
+    coarse.vertex_count = coarse_count;
+    coarse.edge_offsets.push_back(0);
+
+    std::vector<size_t> members;
+    for (size_t e = 0; e < fine.edge_count; e++) {
+        members.clear();
+        for (auto v = fine.edge_begin(e); v != fine.edge_end(e); v++)
+            members.push_back(res.parent[*v]);
+
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
+
+        // An edge contracted into a single vertex no longer pulls on anything
+        if (members.size() < 2)
+            continue;
+
+        coarse.edge_vertices.insert(coarse.edge_vertices.end(), members.begin(), members.end());
+        coarse.edge_offsets.push_back(coarse.edge_vertices.size());
+    }
+    coarse.edge_count = coarse.edge_offsets.size() - 1;
+    coarse.build_vertex_edges();
+
+    return res;
+}
+
+// Lays out the hypergraph by repeatedly coarsening it until it is small, laying out the coarsest level from random
+// positions and then placing every vertex of each finer level at the position of its parent and refining with a
+// short, cool run of the force layout. Once options.deadline has passed the remaining levels are only placed at
+// their parents. The iterations of every level and the energy of the finest one are added to progress when it is set,
+// its frames place every vertex at its ancestor on the level that is being laid out.
+inline std::vector<Vec2f> multilevel_layout(const Incidence& incidence, const ForceLayoutOptions& options, ThreadPool* pool = nullptr, LayoutProgress* progress = nullptr) {
+    constexpr size_t coarsest_size = 64;
+    constexpr double min_reduction = 0.9;
+
+    std::vector<CoarseLevel> levels;
+
+    {
+        const Incidence* fine = &incidence;
+        std::vector<double> masses(incidence.vertex_count, 1.0);
+
+        while (fine->vertex_count > coarsest_size) {
+            auto level = coarsen(*fine, levels.empty() ? masses : levels.back().masses, options.seed + levels.size());
+
+            // Stop when hardly anything could be matched, e.g. only isolated vertices are left
+            if ((double)level.incidence.vertex_count > min_reduction * (double)fine->vertex_count)
+                break;
+
+            levels.push_back(std::move(level));
+            fine = &levels.back().incidence;
+        }
+    }
+
+    // Positions of the vertices of the input from those of the level after depth contractions
+    auto frame_positions = [&](size_t depth) {
+        return [&levels, depth, n = incidence.vertex_count](const std::vector<Vec2f>& level_positions) {
+            std::vector<Vec2f> res(n);
+            for (size_t v = 0; v < n; v++) {
+                auto ancestor = v;
+                for (size_t l = 0; l < depth; l++)
+                    ancestor = levels[l].parent[ancestor];
+                res[v] = level_positions[ancestor];
+            }
+            return res;
+        };
+    };
+
+    auto& coarsest = levels.empty() ? incidence : levels.back().incidence;
+
+    auto positions = random_positions(coarsest.vertex_count, options.edge_length, options.seed);
+    {
+        ForceLayout layout(coarsest, positions, options, pool);
+        layout.masses = levels.empty() ? nullptr : &levels.back().masses;
+        if (!levels.empty())
+            layout.frame_positions = frame_positions(levels.size());
+        layout.run(progress);
+        if (progress && levels.empty())
+            progress->energy += layout.energy;
+    }
+
+    auto refine_options = options;
+    refine_options.iterations = std::max<size_t>(options.iterations / 5, 20);
+    refine_options.temperature = options.edge_length * 2;
+
+    for (size_t l = levels.size(); l-- > 0;) {
+        auto& level = levels[l];
+        auto& fine = l == 0 ? incidence : levels[l - 1].incidence;
+
+        // Start each vertex next to its parent, in a direction that only depends on its index so that pairs separate
+        std::vector<Vec2f> fine_positions(fine.vertex_count);
+        for (size_t v = 0; v < fine.vertex_count; v++) {
+            auto offset = Vec2f{ std::cos(v * 2.399963), std::sin(v * 2.399963) } * (0.25 * options.edge_length);
+            fine_positions[v] = positions[level.parent[v]] + offset;
+        }
+        positions = std::move(fine_positions);
+
+        ForceLayout layout(fine, positions, refine_options, pool);
+        layout.masses = l == 0 ? nullptr : &levels[l - 1].masses;
+        if (l > 0)
+            layout.frame_positions = frame_positions(l);
+        layout.run(progress);
+        if (progress && l == 0)
+            progress->energy += layout.energy;
+    }
+
+    return positions;
+}
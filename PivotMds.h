@@ -0,0 +1,340 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Incidence.h"
+#include "LayoutProgress.h"
+#include "ThreadPool.h"
+#include "Vec2f.h"
+
+struct PivotMdsOptions {
+    // Vertices that distances are measured from
+    size_t pivots = 50;
+    // Sweeps of sparse stress majorization after the embedding, 0 for none
+    size_t stress_iterations = 20;
+    double edge_length = 60;
+    uint64_t seed = 0;
+    // Once it has passed no more pivots are added, beyond the first two, and no more stress sweeps start
+    Deadline deadline = no_deadline;
+};
+
+// Hyperedges bigger than this give no stress terms between their vertices, which would be quadratic in their size.
+// Their vertices are still placed by the distances to the pivots.
+static constexpr size_t stress_max_edge_size = 32;
+
+// Most stress terms a vertex gets from the vertices around it, besides the pivots
+static constexpr size_t stress_max_neighbours = 64;
+
+// Distance from a pivot to a vertex that it can not reach
+static constexpr uint16_t unreachable_hops = UINT16_MAX;
+
+// Hop distances from source, a hop goes from a vertex to all other vertices of one of its hyperedges. Every
+// hyperedge is expanded once so a search costs O(incidences). Distances saturate below unreachable_hops.
+inline void hyperedge_bfs(const Incidence& incidence, size_t source, uint16_t* hops, std::vector<size_t>& queue, std::vector<char>& edge_seen) {
+    std::fill(hops, hops + incidence.vertex_count, unreachable_hops);
+    edge_seen.assign(incidence.edge_count, 0);
+    queue.clear();
+
+    hops[source] = 0;
+    queue.push_back(source);
+    for (size_t head = 0; head < queue.size(); head++) {
+        auto v = queue[head];
+        auto next = (uint16_t)std::min<int>(hops[v] + 1, unreachable_hops - 1);
+        for (auto e = incidence.vertex_begin(v); e != incidence.vertex_end(v); e++) {
+            if (edge_seen[*e])
+                continue;
+            edge_seen[*e] = 1;
+            for (auto u = incidence.edge_begin(*e); u != incidence.edge_end(*e); u++) {
+                if (hops[*u] == unreachable_hops) {
+                    hops[*u] = next;
+                    queue.push_back(*u);
+                }
+            }
+        }
+    }
+}
+
+// Pivot MDS (Brandes and Pich) with sparse stress refinement.
+// Pivots are picked one at a time as the vertex furthest from all pivots so far, starting from a vertex chosen by the
+// seed, and a breadth first search over the hyperedges gives the hop distance of every vertex to every pivot. The
+// double centered squared distances to the pivots form an n x k matrix C, the top two eigenvectors of the k x k matrix
+// C^T C found by power iteration give the axes of the embedding. Stress majorization then moves every vertex towards
+// the distances to the vertices up to two hops away through small hyperedges and to the pivots. Memory is O(n k) and
+// time O(k incidences + n k^2) plus O(n (k + neighbours)) per stress sweep. The stress sweeps and the stress before
+// the last one are added to progress when it is set, its frames start with the embedding.
+inline std::vector<Vec2f> pivot_mds_layout(const Incidence& incidence, const PivotMdsOptions& options, ThreadPool* pool = nullptr, LayoutProgress* progress = nullptr) {
+    auto n = incidence.vertex_count;
+    if (n == 0)
+        return {};
+    if (n == 1)
+        return { Vec2f{} };
+
+    auto parallel_for = [&](size_t count, size_t grain, auto&& f) {
+        if (pool)
+            pool->parallel_for(count, grain, f);
+        else
+            f((size_t)0, count);
+    };
+
+    auto k = std::clamp<size_t>(options.pivots, 2, n);
+
+    // hops[p * n + v] is the distance from pivot p to vertex v
+    std::vector<uint16_t> hops(k * n);
+    std::vector<size_t> pivots;
+    bool out_of_time = false;
+    {
+        std::vector<size_t> queue;
+        std::vector<char> edge_seen;
+        std::vector<uint16_t> nearest(n, unreachable_hops);
+
+        auto next = (size_t)(std::mt19937_64(options.seed)() % n);
+        for (size_t p = 0; p < k; p++) {
+            pivots.push_back(next);
+            auto row = hops.data() + p * n;
+            hyperedge_bfs(incidence, next, row, queue, edge_seen);
+
+            // Unreachable vertices count as furthest so every part of a disconnected input gets a pivot
+            for (size_t v = 0; v < n; v++) {
+                nearest[v] = std::min(nearest[v], row[v]);
+                if (nearest[v] > nearest[next])
+                    next = v;
+            }
+
+            if (p >= 1 && p + 1 < k && past_deadline(options.deadline)) {
+                out_of_time = true;
+                k = p + 1;
+                hops.resize(k * n);
+            }
+        }
+    }
+
+    // Unreachable pairs are placed a little further apart than the furthest reachable pair
+    uint16_t max_hops = 1;
+    for (auto h : hops) {
+        if (h != unreachable_hops)
+            max_hops = std::max(max_hops, h);
+    }
+    auto distance = [&](size_t p, size_t v) -> double {
+        auto h = hops[p * n + v];
+        return h == unreachable_hops ? max_hops + 1.0 : h;
+    };
+
+    // C[v][p] = -1/2 (d^2 - row_mean[v] - col_mean[p] + grand_mean) with the means of the squared distances,
+    // col_shift[p] is col_mean[p] - grand_mean
+    std::vector<double> row_mean(n, 0);
+    std::vector<double> col_shift(k, 0);
+    parallel_for(n, 4096, [&](size_t begin, size_t end) {
+        for (auto v = begin; v < end; v++) {
+            double sum = 0;
+            for (size_t p = 0; p < k; p++)
+                sum += distance(p, v) * distance(p, v);
+            row_mean[v] = sum / k;
+        }
+    });
+    double grand_mean = 0;
+    for (auto r : row_mean)
+        grand_mean += r;
+    grand_mean /= n;
+    parallel_for(k, 1, [&](size_t begin, size_t end) {
+        for (auto p = begin; p < end; p++) {
+            double sum = 0;
+            for (size_t v = 0; v < n; v++)
+                sum += distance(p, v) * distance(p, v);
+            col_shift[p] = sum / n - grand_mean;
+        }
+    });
+    auto centered = [&](size_t p, size_t v) { return -0.5 * (distance(p, v) * distance(p, v) - row_mean[v] - col_shift[p]); };
+
+    // C^T C, every entry is a dot product of two columns of C
+    std::vector<double> ctc(k * k, 0);
+    parallel_for(k, 1, [&](size_t begin, size_t end) {
+        std::vector<double> column(n);
+        for (auto p = begin; p < end; p++) {
+            for (size_t v = 0; v < n; v++)
+                column[v] = centered(p, v);
+            for (size_t q = 0; q <= p; q++) {
+                double sum = 0;
+                for (size_t v = 0; v < n; v++)
+                    sum += column[v] * centered(q, v);
+                ctc[p * k + q] = sum;
+                ctc[q * k + p] = sum;
+            }
+        }
+    });
+
+    // Orthogonal iteration for the two largest eigenvectors, from fixed start vectors so the result is reproducible
+    std::vector<double> axes[2] = { std::vector<double>(k), std::vector<double>(k) };
+    for (size_t p = 0; p < k; p++) {
+        axes[0][p] = 1.0 + p % 3;
+        axes[1][p] = p % 2 ? 1.0 : -1.0;
+    }
+    std::vector<double> product(k);
+    for (size_t iteration = 0; iteration < 200; iteration++) {
+        for (auto& axis : axes) {
+            for (size_t p = 0; p < k; p++) {
+                double sum = 0;
+                for (size_t q = 0; q < k; q++)
+                    sum += ctc[p * k + q] * axis[q];
+                product[p] = sum;
+            }
+            axis.swap(product);
+        }
+
+        // Gram-Schmidt keeps the second axis from collapsing onto the first
+        for (size_t a = 0; a < 2; a++) {
+            for (size_t b = 0; b < a; b++) {
+                double dot = 0;
+                for (size_t p = 0; p < k; p++)
+                    dot += axes[a][p] * axes[b][p];
+                for (size_t p = 0; p < k; p++)
+                    axes[a][p] -= dot * axes[b][p];
+            }
+            double length = 0;
+            for (auto x : axes[a])
+                length += x * x;
+            length = std::sqrt(length);
+            if (length > 0) {
+                for (auto& x : axes[a])
+                    x /= length;
+            }
+        }
+    }
+
+    std::vector<Vec2f> positions(n);
+    parallel_for(n, 4096, [&](size_t begin, size_t end) {
+        for (auto v = begin; v < end; v++) {
+            Vec2f p = {};
+            for (size_t q = 0; q < k; q++) {
+                auto c = centered(q, v);
+                p.x += c * axes[0][q];
+                p.y += c * axes[1][q];
+            }
+            positions[v] = p;
+        }
+    });
+
+    // The embedding is only right up to scale, pick the one that best fits the distances to the pivots
+    double fit = 0;
+    double norm = 0;
+    for (size_t p = 0; p < k; p++) {
+        for (size_t v = 0; v < n; v++) {
+            if (hops[p * n + v] == unreachable_hops)
+                continue;
+            auto d = (positions[v] - positions[pivots[p]]).length();
+            fit += d * distance(p, v);
+            norm += d * d;
+        }
+    }
+    auto scale = norm > 0 ? fit / norm : 1.0;
+    for (auto& p : positions)
+        p = p * scale;
+
+    auto frame = [&]() {
+        std::vector<Vec2f> res(n);
+        for (size_t v = 0; v < n; v++)
+            res[v] = positions[v] * options.edge_length;
+        progress->on_frame(res);
+    };
+    if (progress && progress->on_frame)
+        frame();
+
+    if (options.stress_iterations > 0) {
+        // Vertices with the same distances to every pivot are embedded on the same point and would pull on each other
+        // in no particular direction, a tiny offset that only depends on the vertex separates them
+        for (size_t v = 0; v < n; v++)
+            positions[v] += Vec2f{ std::cos(v * 2.399963), std::sin(v * 2.399963) } * 0.01;
+
+        // Neighbours in small hyperedges one hop apart, then their neighbours two hops apart up to
+        // stress_max_neighbours in all. The second ring keeps vertices that hang off the same vertex apart.
+        std::vector<size_t> neighbour_offsets(n + 1, 0);
+        std::vector<size_t> neighbours;
+        std::vector<uint8_t> neighbour_hops;
+        std::vector<size_t> mark(n, SIZE_MAX);
+        auto add_ring = [&](size_t v, size_t from, uint8_t h) {
+            for (auto e = incidence.vertex_begin(from); e != incidence.vertex_end(from); e++) {
+                if (incidence.edge_size(*e) > stress_max_edge_size)
+                    continue;
+                for (auto u = incidence.edge_begin(*e); u != incidence.edge_end(*e); u++) {
+                    if (neighbours.size() - neighbour_offsets[v] >= stress_max_neighbours)
+                        return;
+                    if (*u != v && mark[*u] != v) {
+                        mark[*u] = v;
+                        neighbours.push_back(*u);
+                        neighbour_hops.push_back(h);
+                    }
+                }
+            }
+        };
+        for (size_t v = 0; v < n; v++) {
+            neighbour_offsets[v] = neighbours.size();
+            add_ring(v, v, 1);
+            auto first_ring_end = neighbours.size();
+            for (auto i = neighbour_offsets[v]; i < first_ring_end; i++)
+                add_ring(v, neighbours[i], 2);
+        }
+        neighbour_offsets[n] = neighbours.size();
+
+        // Calls f(u, d) for every vertex u that v should be d hops away from
+        auto for_each_term = [&](size_t v, auto&& f) {
+            for (auto i = neighbour_offsets[v]; i < neighbour_offsets[v + 1]; i++)
+                f(neighbours[i], (double)neighbour_hops[i]);
+            for (size_t p = 0; p < k; p++) {
+                auto h = hops[p * n + v];
+                if (h != 0 && h != unreachable_hops)
+                    f(pivots[p], (double)h);
+            }
+        };
+
+        // Every sweep moves each vertex to the weighted mean of where each of its terms wants it, computed from the
+        // previous positions only so the result does not depend on the thread count. The weighted stress of the
+        // previous positions, in units of edge_length, is summed up on the way.
+        std::vector<Vec2f> next(n);
+        std::vector<double> stress(n);
+        size_t iteration = 0;
+        for (; iteration < options.stress_iterations && !past_deadline(options.deadline); iteration++) {
+            parallel_for(n, 1024, [&](size_t begin, size_t end) {
+                for (auto v = begin; v < end; v++) {
+                    auto pos = positions[v];
+                    Vec2f sum = {};
+                    double weights = 0;
+                    stress[v] = 0;
+
+                    for_each_term(v, [&](size_t u, double d) {
+                        auto delta = pos - positions[u];
+                        auto length = delta.length();
+                        auto w = 1 / (d * d);
+                        sum += (positions[u] + (length > 0 ? delta * (d / length) : Vec2f{})) * w;
+                        weights += w;
+                        stress[v] += (length - d) * (length - d) * w;
+                    });
+
+                    next[v] = weights > 0 ? sum / weights : pos;
+                }
+            });
+            positions.swap(next);
+            if (progress && progress->frame_due())
+                frame();
+        }
+        out_of_time = out_of_time || iteration < options.stress_iterations;
+
+        // In order so that the sum does not depend on the thread count either
+        if (progress && iteration > 0) {
+            progress->iterations += iteration;
+            for (auto x : stress)
+                progress->energy += x;
+        }
+    }
+
+    if (progress)
+        progress->out_of_time = progress->out_of_time || out_of_time;
+
+    for (auto& p : positions)
+        p = p * options.edge_length;
+    return positions;
+}
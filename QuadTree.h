@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "Vec2f.h"
+
+// Region quadtree over a set of points that stores the mass and center of mass of every cell.
+// Used for Barnes-Hut approximation of all pairs forces.
+struct QuadTree {
+    struct Node {
+        Vec2f center = {};
+        double mass = 0;
+
+        Vec2f min = {};
+        double size = 0;
+
+        // Children are 4 consecutive nodes, 0 for a leaf since the root is never a child
+        size_t first_child = 0;
+
+        // Range of points inside the cell in order
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    static constexpr int max_depth = 32;
+    static constexpr size_t leaf_size = 8;
+
+    std::vector<Node> nodes;
+    std::vector<size_t> order;
+
+    // Points and masses copied in order so leaves are read sequentially
+    std::vector<Vec2f> ordered_points;
+    std::vector<double> ordered_masses;
+
+    void build(const std::vector<Vec2f>& points, const std::vector<double>* masses = nullptr) {
+        nodes.clear();
+        order.resize(points.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        if (points.empty())
+            return;
+
+        Vec2f min = { INFINITY, INFINITY };
+        Vec2f max = { -INFINITY, -INFINITY };
+        for (auto& p : points) {
+            min.x = std::min(min.x, p.x);
+            min.y = std::min(min.y, p.y);
+            max.x = std::max(max.x, p.x);
+            max.y = std::max(max.y, p.y);
+        }
+
+        double size = std::max(max.x - min.x, max.y - min.y);
+        if (size <= 0)
+            size = 1;
+
+        nodes.push_back({ .min = min, .size = size * 1.0001, .begin = 0, .end = points.size() });
+        build_node(points, masses, 0, 0);
+
+        ordered_points.resize(points.size());
+        ordered_masses.resize(points.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            ordered_points[i] = points[order[i]];
+            ordered_masses[i] = masses ? (*masses)[order[i]] : 1.0;
+        }
+    }
+
+    // Calls f(center, mass) with every cell that is far enough from p to be approximated
+    // and with every individual point other than index in cells that are not.
+    template <typename F>
+    void visit(Vec2f p, size_t index, double theta, F&& f) const {
+        if (nodes.empty())
+            return;
+
+        size_t stack[max_depth * 4 + 4];
+        size_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            auto& n = nodes[stack[--top]];
+            if (n.mass == 0)
+                continue;
+
+            bool inside = p.x >= n.min.x && p.x < n.min.x + n.size && p.y >= n.min.y && p.y < n.min.y + n.size;
+
+            if (!inside) {
+                auto dx = n.center.x - p.x;
+                auto dy = n.center.y - p.y;
+                if (n.size * n.size < theta * theta * (dx * dx + dy * dy)) {
+                    f(n.center, n.mass);
+                    continue;
+                }
+            }
+
+            if (n.first_child != 0) {
+                for (size_t c = 0; c < 4; c++)
+                    stack[top++] = n.first_child + c;
+            } else {
+                for (auto i = n.begin; i < n.end; i++) {
+                    if (order[i] != index)
+                        f(ordered_points[i], ordered_masses[i]);
+                }
+            }
+        }
+    }
+
+  private:
+    void build_node(const std::vector<Vec2f>& points, const std::vector<double>* masses, size_t node, int depth) {
+        {
+            auto& n = nodes[node];
+            Vec2f sum = {};
+            for (auto i = n.begin; i < n.end; i++) {
+                auto m = masses ? (*masses)[order[i]] : 1.0;
+                sum += points[order[i]] * m;
+                n.mass += m;
+            }
+            if (n.mass > 0)
+                n.center = sum / n.mass;
+
+            if (n.end - n.begin <= leaf_size || depth >= max_depth)
+                return;
+        }
+
+        auto min = nodes[node].min;
+        auto half = nodes[node].size / 2;
+        auto mid = min + Vec2f{ half, half };
+
+        auto b = order.begin() + nodes[node].begin;
+        auto e = order.begin() + nodes[node].end;
+
+        auto split_y = std::partition(b, e, [&](size_t i) { return points[i].y < mid.y; });
+        auto split_lo = std::partition(b, split_y, [&](size_t i) { return points[i].x < mid.x; });
+        auto split_hi = std::partition(split_y, e, [&](size_t i) { return points[i].x < mid.x; });
+
+        size_t bounds[5] = {
+            (size_t)(b - order.begin()),
+            (size_t)(split_lo - order.begin()),
+            (size_t)(split_y - order.begin()),
+            (size_t)(split_hi - order.begin()),
+            (size_t)(e - order.begin()),
+        };
+
+        Vec2f mins[4] = { min, { mid.x, min.y }, { min.x, mid.y }, mid };
+
+        auto first_child = nodes.size();
+        nodes[node].first_child = first_child;
+
+        for (size_t c = 0; c < 4; c++)
+            nodes.push_back({ .min = mins[c], .size = half, .begin = bounds[c], .end = bounds[c + 1] });
+
+        for (size_t c = 0; c < 4; c++)
+            build_node(points, masses, first_child + c, depth + 1);
+    }
+};
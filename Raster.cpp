@@ -0,0 +1,638 @@
+#include "Raster.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <string>
+
+#include "Hypergraph.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+struct NamedColor {
+    const char* name;
+    uint32_t rgb;
+};
+
+// CSS named colors, sorted by name
+const NamedColor named_colors[] = {
+    { "aliceblue", 0xf0f8ff }, { "antiquewhite", 0xfaebd7 }, { "aqua", 0x00ffff }, { "aquamarine", 0x7fffd4 }, { "azure", 0xf0ffff },
+    { "beige", 0xf5f5dc }, { "bisque", 0xffe4c4 }, { "black", 0x000000 }, { "blanchedalmond", 0xffebcd }, { "blue", 0x0000ff },
+    { "blueviolet", 0x8a2be2 }, { "brown", 0xa52a2a }, { "burlywood", 0xdeb887 }, { "cadetblue", 0x5f9ea0 }, { "chartreuse", 0x7fff00 },
+    { "chocolate", 0xd2691e }, { "coral", 0xff7f50 }, { "cornflowerblue", 0x6495ed }, { "cornsilk", 0xfff8dc }, { "crimson", 0xdc143c },
+    { "cyan", 0x00ffff }, { "darkblue", 0x00008b }, { "darkcyan", 0x008b8b }, { "darkgoldenrod", 0xb8860b }, { "darkgray", 0xa9a9a9 },
+    { "darkgreen", 0x006400 }, { "darkgrey", 0xa9a9a9 }, { "darkkhaki", 0xbdb76b }, { "darkmagenta", 0x8b008b }, { "darkolivegreen", 0x556b2f },
+    { "darkorange", 0xff8c00 }, { "darkorchid", 0x9932cc }, { "darkred", 0x8b0000 }, { "darksalmon", 0xe9967a }, { "darkseagreen", 0x8fbc8f },
+    { "darkslateblue", 0x483d8b }, { "darkslategray", 0x2f4f4f }, { "darkslategrey", 0x2f4f4f }, { "darkturquoise", 0x00ced1 },
+    { "darkviolet", 0x9400d3 }, { "deeppink", 0xff1493 }, { "deepskyblue", 0x00bfff }, { "dimgray", 0x696969 }, { "dimgrey", 0x696969 },
+    { "dodgerblue", 0x1e90ff }, { "firebrick", 0xb22222 }, { "floralwhite", 0xfffaf0 }, { "forestgreen", 0x228b22 }, { "fuchsia", 0xff00ff },
+    { "gainsboro", 0xdcdcdc }, { "ghostwhite", 0xf8f8ff }, { "gold", 0xffd700 }, { "goldenrod", 0xdaa520 }, { "gray", 0x808080 },
+    { "green", 0x008000 }, { "greenyellow", 0xadff2f }, { "grey", 0x808080 }, { "honeydew", 0xf0fff0 }, { "hotpink", 0xff69b4 },
+    { "indianred", 0xcd5c5c }, { "indigo", 0x4b0082 }, { "ivory", 0xfffff0 }, { "khaki", 0xf0e68c }, { "lavender", 0xe6e6fa },
+    { "lavenderblush", 0xfff0f5 }, { "lawngreen", 0x7cfc00 }, { "lemonchiffon", 0xfffacd }, { "lightblue", 0xadd8e6 }, { "lightcoral", 0xf08080 },
+    { "lightcyan", 0xe0ffff }, { "lightgoldenrodyellow", 0xfafad2 }, { "lightgray", 0xd3d3d3 }, { "lightgreen", 0x90ee90 }, { "lightgrey", 0xd3d3d3 },
+    { "lightpink", 0xffb6c1 }, { "lightsalmon", 0xffa07a }, { "lightseagreen", 0x20b2aa }, { "lightskyblue", 0x87cefa },
+    { "lightslategray", 0x778899 }, { "lightslategrey", 0x778899 }, { "lightsteelblue", 0xb0c4de }, { "lightyellow", 0xffffe0 }, { "lime", 0x00ff00 },
+    { "limegreen", 0x32cd32 }, { "linen", 0xfaf0e6 }, { "magenta", 0xff00ff }, { "maroon", 0x800000 }, { "mediumaquamarine", 0x66cdaa },
+    { "mediumblue", 0x0000cd }, { "mediumorchid", 0xba55d3 }, { "mediumpurple", 0x9370db }, { "mediumseagreen", 0x3cb371 },
+    { "mediumslateblue", 0x7b68ee }, { "mediumspringgreen", 0x00fa9a }, { "mediumturquoise", 0x48d1cc }, { "mediumvioletred", 0xc71585 },
+    { "midnightblue", 0x191970 }, { "mintcream", 0xf5fffa }, { "mistyrose", 0xffe4e1 }, { "moccasin", 0xffe4b5 }, { "navajowhite", 0xffdead },
+    { "navy", 0x000080 }, { "oldlace", 0xfdf5e6 }, { "olive", 0x808000 }, { "olivedrab", 0x6b8e23 }, { "orange", 0xffa500 },
+    { "orangered", 0xff4500 }, { "orchid", 0xda70d6 }, { "palegoldenrod", 0xeee8aa }, { "palegreen", 0x98fb98 }, { "paleturquoise", 0xafeeee },
+    { "palevioletred", 0xdb7093 }, { "papayawhip", 0xffefd5 }, { "peachpuff", 0xffdab9 }, { "peru", 0xcd853f }, { "pink", 0xffc0cb },
+    { "plum", 0xdda0dd }, { "powderblue", 0xb0e0e6 }, { "purple", 0x800080 }, { "rebeccapurple", 0x663399 }, { "red", 0xff0000 },
+    { "rosybrown", 0xbc8f8f }, { "royalblue", 0x4169e1 }, { "saddlebrown", 0x8b4513 }, { "salmon", 0xfa8072 }, { "sandybrown", 0xf4a460 },
+    { "seagreen", 0x2e8b57 }, { "seashell", 0xfff5ee }, { "sienna", 0xa0522d }, { "silver", 0xc0c0c0 }, { "skyblue", 0x87ceeb },
+    { "slateblue", 0x6a5acd }, { "slategray", 0x708090 }, { "slategrey", 0x708090 }, { "snow", 0xfffafa }, { "springgreen", 0x00ff7f },
+    { "steelblue", 0x4682b4 }, { "tan", 0xd2b48c }, { "teal", 0x008080 }, { "thistle", 0xd8bfd8 }, { "tomato", 0xff6347 }, { "turquoise", 0x40e0d0 },
+    { "violet", 0xee82ee }, { "wheat", 0xf5deb3 }, { "white", 0xffffff }, { "whitesmoke", 0xf5f5f5 }, { "yellow", 0xffff00 },
+    { "yellowgreen", 0x9acd32 },
+};
+
+Rgba from_rgb(uint32_t rgb) { return { ((rgb >> 16) & 0xff) / 255.0f, ((rgb >> 8) & 0xff) / 255.0f, (rgb & 0xff) / 255.0f, 1.0f }; }
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Parses the arguments of rgb() and rgba(), numbers from 0 to 255 or percentages and an optional alpha
+std::optional<Rgba> parse_rgb_function(std::string_view args) {
+    float values[4] = { 0, 0, 0, 1 };
+    size_t count = 0;
+
+    std::string str(args);
+    const char* p = str.c_str();
+    while (*p) {
+        while (*p == ' ' || *p == ',' || *p == '/')
+            p++;
+        if (!*p)
+            break;
+        if (count == 4)
+            return std::nullopt;
+
+        char* end;
+        auto v = strtof(p, &end);
+        if (end == p)
+            return std::nullopt;
+        p = end;
+
+        if (*p == '%') {
+            v /= 100;
+            p++;
+        } else if (count < 3) {
+            v /= 255;
+        }
+        values[count++] = std::clamp(v, 0.0f, 1.0f);
+    }
+
+    if (count < 3)
+        return std::nullopt;
+    return Rgba{ values[0], values[1], values[2], values[3] };
+}
+
+} // namespace
+
+std::optional<Rgba> parse_color(std::string_view str) {
+    while (!str.empty() && str.front() == ' ')
+        str.remove_prefix(1);
+    while (!str.empty() && str.back() == ' ')
+        str.remove_suffix(1);
+
+    std::string lower(str);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+    if (lower == "none" || lower == "transparent")
+        return Rgba{};
+
+    if (lower.starts_with('#')) {
+        int digits[8];
+        auto n = lower.size() - 1;
+        if (n != 3 && n != 4 && n != 6 && n != 8)
+            return std::nullopt;
+        for (size_t i = 0; i < n; i++) {
+            digits[i] = hex_digit(lower[i + 1]);
+            if (digits[i] < 0)
+                return std::nullopt;
+        }
+
+        // #rgb and #rgba repeat every digit
+        float channels[4] = { 1, 1, 1, 1 };
+        for (size_t c = 0; c < (n == 3 || n == 6 ? 3 : 4); c++) {
+            auto v = n <= 4 ? digits[c] * 17 : digits[2 * c] * 16 + digits[2 * c + 1];
+            channels[c] = v / 255.0f;
+        }
+        return Rgba{ channels[0], channels[1], channels[2], channels[3] };
+    }
+
+    for (std::string_view prefix : { "rgba(", "rgb(" }) {
+        if (lower.starts_with(prefix) && lower.ends_with(')'))
+            return parse_rgb_function(std::string_view(lower).substr(prefix.size(), lower.size() - prefix.size() - 1));
+    }
+
+    auto it = std::lower_bound(std::begin(named_colors), std::end(named_colors), lower, [](const NamedColor& c, const std::string& name) { return c.name < name; });
+    if (it != std::end(named_colors) && it->name == lower)
+        return from_rgb(it->rgb);
+
+    return std::nullopt;
+}
+
+void Rasterizer::begin(long x0, long y0, long x1, long y1) {
+    this->x0 = x0;
+    this->y0 = y0;
+    this->x1 = std::max(x0, x1);
+    this->y1 = std::max(y0, y1);
+    stride = this->x1 - x0 + 2;
+
+    // fill leaves the accumulation and the touched blocks cleared, so only newly added space has to be cleared
+    auto rows = (size_t)(this->y1 - y0);
+    if (accumulation.size() < stride * rows)
+        accumulation.resize(stride * rows, 0.0f);
+    words_per_row = (stride + block_size * 64 - 1) / (block_size * 64);
+    if (touched.size() < words_per_row * rows)
+        touched.resize(words_per_row * rows, 0);
+    first_row = (long)rows;
+    last_row = -1;
+}
+
+void Rasterizer::touch(long y, long first, long last) {
+    first_row = std::min(first_row, y);
+    last_row = std::max(last_row, y);
+    auto words = touched.data() + y * words_per_row;
+    for (auto b = first / (long)block_size; b <= last / (long)block_size; b++)
+        words[b / 64] |= uint64_t(1) << (b % 64);
+}
+
+void Rasterizer::line(Vec2f a, Vec2f b) {
+    // Most lines of a big shape miss the rows of a band entirely
+    if (empty() || std::max(a.y, b.y) <= (double)y0 || std::min(a.y, b.y) >= (double)y1)
+        return;
+
+    a = a - Vec2f{ (double)x0, (double)y0 };
+    b = b - Vec2f{ (double)x0, (double)y0 };
+
+    // The parts of the line left and right of the clip rectangle are moved onto its border, they still cover
+    // everything to their right but nothing they would not have covered
+    double w = (double)(x1 - x0);
+    double ts[4] = { 0 };
+    size_t n = 1;
+    for (double border : { 0.0, w }) {
+        if ((a.x - border) * (b.x - border) < 0)
+            ts[n++] = (border - a.x) / (b.x - a.x);
+    }
+    ts[n++] = 1;
+    std::sort(ts + 1, ts + n - 1);
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        auto p = a + (b - a) * ts[i];
+        auto q = a + (b - a) * ts[i + 1];
+        p.x = std::clamp(p.x, 0.0, w);
+        q.x = std::clamp(q.x, 0.0, w);
+        clipped_line(p, q);
+    }
+}
+
+void Rasterizer::clipped_line(Vec2f a, Vec2f b) {
+    if (a.y == b.y)
+        return;
+
+    float dir = 1;
+    if (a.y > b.y) {
+        std::swap(a, b);
+        dir = -1;
+    }
+
+    auto height = (double)(y1 - y0);
+    if (b.y <= 0 || a.y >= height)
+        return;
+
+    auto dxdy = (b.x - a.x) / (b.y - a.y);
+    auto x = a.x;
+    if (a.y < 0)
+        x -= a.y * dxdy;
+
+    // Everything is inside the clip rectangle now so truncation rounds down, std::floor and std::ceil are library
+    // calls on baseline x86-64
+    auto y_begin = a.y > 0 ? (long)a.y : 0;
+    auto y_end = (long)std::min(height, b.y);
+    if ((double)y_end < std::min(height, b.y))
+        y_end++;
+
+    for (auto y = y_begin; y < y_end; y++) {
+        auto acc = accumulation.data() + y * stride;
+
+        auto dy = std::min((double)(y + 1), b.y) - std::max((double)y, a.y);
+        auto x_next = x + dxdy * dy;
+        auto d = (float)(dy * dir);
+
+        auto left = std::min(x, x_next);
+        auto right = std::max(x, x_next);
+        auto left_i = (long)left;
+        auto left_floor = (double)left_i;
+        auto right_i = (long)right;
+        if ((double)right_i < right)
+            right_i++;
+        auto right_ceil = (double)right_i;
+
+        if (right_i <= left_i + 1) {
+            // Within one pixel, split by the mean x
+            auto xmf = (float)(0.5 * (x + x_next) - left_floor);
+            acc[left_i] += d - d * xmf;
+            acc[left_i + 1] += d * xmf;
+            touch(y, left_i, left_i + 1);
+        } else {
+            auto s = (float)(1 / (right - left));
+            auto left_f = (float)(left - left_floor);
+            auto a0 = 0.5f * s * (1 - left_f) * (1 - left_f);
+            auto right_f = (float)(right - right_ceil + 1);
+            auto am = 0.5f * s * right_f * right_f;
+
+            acc[left_i] += d * a0;
+            if (right_i == left_i + 2) {
+                acc[left_i + 1] += d * (1 - a0 - am);
+            } else {
+                auto a1 = s * (1.5f - left_f);
+                acc[left_i + 1] += d * (a1 - a0);
+                for (auto xi = left_i + 2; xi < right_i - 1; xi++)
+                    acc[xi] += d * s;
+                auto a2 = a1 + (float)(right_i - left_i - 3) * s;
+                acc[right_i - 1] += d * (1 - a2 - am);
+            }
+            acc[right_i] += d * am;
+            touch(y, left_i, right_i);
+        }
+
+        x = x_next;
+    }
+}
+
+void Rasterizer::polygon(const Vec2f* points, size_t count) {
+    if (count < 2)
+        return;
+
+    // A closed polygon that misses the clip rectangle adds nothing to it, even one to its left crosses every row as
+    // often upwards as downwards. Strokes are made of many small polygons so most are skipped here.
+    Vec2f min = points[0];
+    Vec2f max = points[0];
+    for (size_t i = 1; i < count; i++) {
+        min.x = std::min(min.x, points[i].x);
+        min.y = std::min(min.y, points[i].y);
+        max.x = std::max(max.x, points[i].x);
+        max.y = std::max(max.y, points[i].y);
+    }
+    if (max.x <= (double)x0 || min.x >= (double)x1 || max.y <= (double)y0 || min.y >= (double)y1)
+        return;
+
+    // Coordinates that are not finite would index outside the buffers, the shape is left out instead
+    for (size_t i = 0; i < count; i++) {
+        if (!std::isfinite(points[i].x) || !std::isfinite(points[i].y))
+            return;
+    }
+    for (size_t i = 0; i + 1 < count; i++)
+        line(points[i], points[i + 1]);
+    line(points[count - 1], points[0]);
+}
+
+void Rasterizer::fill(Image& image, Rgba color, float opacity) {
+    auto width = (size_t)(x1 - x0);
+    auto alpha = color.a * opacity;
+
+    // Coverage left over by rounding where a closed shape ends, far below what 8 bit output can show
+    constexpr float min_coverage = 1e-4f;
+
+    coverage.resize(block_size);
+
+    auto composite = [&](float* px, const float* cover, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            auto a = cover[i];
+            auto keep = 1 - a;
+            px[4 * i + 0] = color.r * a + px[4 * i + 0] * keep;
+            px[4 * i + 1] = color.g * a + px[4 * i + 1] * keep;
+            px[4 * i + 2] = color.b * a + px[4 * i + 2] * keep;
+            px[4 * i + 3] = a + px[4 * i + 3] * keep;
+        }
+    };
+
+    for (auto y = first_row; y <= last_row; y++) {
+        auto acc = accumulation.data() + y * stride;
+        auto words = touched.data() + y * words_per_row;
+        auto px = image.row(y + y0) + x0 * 4;
+
+        // Only blocks that lines were added to change the running sum, the coverage between them is constant.
+        // Within a block the sum carries from pixel to pixel, compositing has no dependencies and vectorizes.
+        float sum = 0;
+        size_t x = 0;
+        auto run = [&](size_t end) {
+            auto a = std::min(std::fabs(sum), 1.0f) * alpha;
+            if (a < min_coverage)
+                return;
+            std::fill(coverage.begin(), coverage.end(), a);
+            for (auto bx = x; bx < end; bx += block_size)
+                composite(px + bx * 4, coverage.data(), std::min(block_size, end - bx));
+        };
+
+        for (size_t w = 0; w < words_per_row; w++) {
+            while (words[w]) {
+                auto b = w * 64 + std::countr_zero(words[w]);
+                words[w] &= words[w] - 1;
+
+                auto begin = b * block_size;
+                auto end = std::min(begin + block_size, width);
+                if (begin < width) {
+                    run(begin);
+
+                    float covered = 0;
+                    for (auto i = begin; i < end; i++) {
+                        sum += acc[i];
+                        coverage[i - begin] = std::min(std::fabs(sum), 1.0f) * alpha;
+                        covered = std::max(covered, coverage[i - begin]);
+                    }
+                    if (covered >= min_coverage)
+                        composite(px + begin * 4, coverage.data(), end - begin);
+                    x = end;
+                }
+                std::fill(acc + begin, acc + std::min(begin + block_size, stride), 0.0f);
+            }
+        }
+        run(width);
+    }
+}
+
+void RasterPath::move_to(Vec2f p) {
+    starts.push_back(points.size());
+    points.push_back(to_pixels(p));
+    current = p;
+}
+
+void RasterPath::line_to(Vec2f p) {
+    if (starts.empty())
+        starts.push_back(points.size());
+    points.push_back(to_pixels(p));
+    current = p;
+}
+
+// Number of line segments that keep an arc of radius r (in pixels) and angle sweep within a quarter pixel
+static size_t arc_segments(double r, double sweep) {
+    constexpr double tolerance = 0.25;
+    if (r <= tolerance)
+        return std::max<size_t>(1, (size_t)std::ceil(std::fabs(sweep) / (M_PI / 2)));
+    auto step = 2 * std::acos(1 - tolerance / r);
+    return std::clamp<size_t>((size_t)std::ceil(std::fabs(sweep) / step), 1, 1024);
+}
+
+void RasterPath::arc_to(double rx, double, int large_arc, int sweep, Vec2f p) {
+    // Endpoint to center conversion from the SVG specification, for circular arcs without rotation
+    auto start = current;
+    double r = std::fabs(rx);
+
+    auto half = (start - p) / 2.0;
+    auto half_len2 = half.x * half.x + half.y * half.y;
+    if (r == 0 || half_len2 == 0) {
+        line_to(p);
+        return;
+    }
+
+    // Radii that are too small are scaled up until the arc fits
+    r = std::max(r, std::sqrt(half_len2));
+
+    auto coef = std::sqrt(std::max(0.0, (r * r - half_len2) / half_len2));
+    if (large_arc == sweep)
+        coef = -coef;
+
+    Vec2f center_offset = { coef * half.y, -coef * half.x };
+    auto center = center_offset + (start + p) / 2.0;
+
+    auto theta = std::atan2(half.y - center_offset.y, half.x - center_offset.x);
+    auto delta = std::atan2(-half.y - center_offset.y, -half.x - center_offset.x) - theta;
+    if (sweep && delta < 0)
+        delta += 2 * M_PI;
+    else if (!sweep && delta > 0)
+        delta -= 2 * M_PI;
+
+    auto n = arc_segments(r * scale, delta);
+    for (size_t i = 1; i < n; i++) {
+        auto t = theta + delta * (double)i / (double)n;
+        points.push_back(to_pixels(center + Vec2f{ std::cos(t), std::sin(t) } * r));
+    }
+    line_to(p);
+}
+
+void RasterPath::circle(Vec2f center, double r) {
+    auto n = std::max<size_t>(arc_segments(r * scale, 2 * M_PI), 4);
+    starts.push_back(points.size());
+    for (size_t i = 0; i < n; i++) {
+        auto t = 2 * M_PI * (double)i / (double)n;
+        points.push_back(to_pixels(center + Vec2f{ std::cos(t), std::sin(t) } * r));
+    }
+    // Closed so that strokes go all the way around
+    points.push_back(points[starts.back()]);
+    current = center;
+}
+
+void RasterPath::fill(Rasterizer& r) const {
+    for (size_t i = 0; i < subpath_count(); i++)
+        r.polygon(subpath(i), subpath_size(i));
+}
+
+void RasterPath::stroke(RasterPath& out, double width) const {
+    out.clear();
+    auto hw = width * scale / 2;
+    if (hw <= 0)
+        return;
+
+    // Every segment becomes a rectangle and joins and caps become circles, all counter clockwise so they add up
+    auto join_count = std::max<size_t>(arc_segments(hw, 2 * M_PI), 4);
+    std::vector<Vec2f> circle(join_count);
+    for (size_t i = 0; i < join_count; i++) {
+        auto t = 2 * M_PI * (double)i / (double)join_count;
+        circle[i] = Vec2f{ std::cos(t), std::sin(t) } * hw;
+    }
+    std::vector<Vec2f> join(join_count);
+    auto add_join = [&](Vec2f c) {
+        for (size_t i = 0; i < join_count; i++)
+            join[i] = c + circle[i];
+        out.add_pixel_subpath(join.data(), join.size());
+    };
+
+    for (size_t s = 0; s < subpath_count(); s++) {
+        auto p = subpath(s);
+        auto n = subpath_size(s);
+        if (n == 0)
+            continue;
+
+        add_join(p[0]);
+
+        Vec2f prev_dir = {};
+        for (size_t i = 0; i + 1 < n; i++) {
+            auto a = p[i];
+            auto b = p[i + 1];
+            auto len = (b - a).length();
+            if (len == 0)
+                continue;
+
+            auto dir = (b - a) / len;
+            auto normal = (dir * hw).rot90();
+            Vec2f quad[4] = { a - normal, b - normal, b + normal, a + normal };
+            out.add_pixel_subpath(quad, 4);
+
+            // Flattened arcs turn a little at every point. Where the round join would barely differ from a straight
+            // one the gap on the outside of the turn is filled with a triangle instead of a whole circle.
+            if (i > 0) {
+                auto turn_cos = dir.x * prev_dir.x + dir.y * prev_dir.y;
+                if (hw * (1 - std::sqrt(std::max(0.0, (1 + turn_cos) / 2))) > 0.05) {
+                    add_join(a);
+                } else {
+                    auto turn = prev_dir.x * dir.y - prev_dir.y * dir.x;
+                    auto prev_normal = (prev_dir * hw).rot90();
+                    if (turn > 0) {
+                        Vec2f wedge[3] = { a, a - prev_normal, a - normal };
+                        out.add_pixel_subpath(wedge, 3);
+                    } else if (turn < 0) {
+                        Vec2f wedge[3] = { a, a + normal, a + prev_normal };
+                        out.add_pixel_subpath(wedge, 3);
+                    }
+                }
+            }
+            prev_dir = dir;
+        }
+
+        if (n > 1)
+            add_join(p[n - 1]);
+    }
+}
+
+static uint8_t to_byte(float v) { return (uint8_t)(std::clamp(v, 0.0f, 1.0f) * 255 + 0.5f); }
+
+std::string Image::encode_ppm() const {
+    auto out = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    out.reserve(out.size() + width * height * 3);
+
+    for (size_t y = 0; y < height; y++) {
+        auto px = row(y);
+        for (size_t x = 0; x < width; x++) {
+            auto keep = 1 - px[4 * x + 3];
+            for (size_t c = 0; c < 3; c++)
+                out.push_back((char)to_byte(px[4 * x + c] + keep));
+        }
+    }
+    return out;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const auto table = []() {
+        std::vector<uint32_t> res(256);
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            res[n] = c;
+        }
+        return res;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_u32(std::string& out, uint32_t v) {
+    out.push_back((char)(v >> 24));
+    out.push_back((char)(v >> 16));
+    out.push_back((char)(v >> 8));
+    out.push_back((char)v);
+}
+
+// Wraps data in a zlib stream, compressed when zlib is available and as stored deflate blocks otherwise
+static bool zlib_stream(const std::vector<uint8_t>& data, std::string& out) {
+#ifdef HAVE_ZLIB
+    auto size = compressBound(data.size());
+    out.resize(size);
+    // The fastest level is several times faster than the default on drawings for only slightly bigger files
+    if (compress2((Bytef*)out.data(), &size, data.data(), data.size(), Z_BEST_SPEED) != Z_OK)
+        return false;
+    out.resize(size);
+    return true;
+#else
+    out.clear();
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    size_t pos = 0;
+    do {
+        auto len = std::min<size_t>(data.size() - pos, 65535);
+        out.push_back(pos + len == data.size() ? 1 : 0);
+        out.push_back((char)(len & 0xff));
+        out.push_back((char)(len >> 8));
+        out.push_back((char)(~len & 0xff));
+        out.push_back((char)((~len >> 8) & 0xff));
+        out.append((const char*)data.data() + pos, len);
+        pos += len;
+    } while (pos < data.size());
+
+    uint32_t a = 1, b = 0;
+    for (auto byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_u32(out, (b << 16) | a);
+    return true;
+#endif
+}
+
+std::string Image::encode_png() const {
+    // Every row starts with filter type 0, colors are stored without premultiplication
+    std::vector<uint8_t> raw(height * (width * 4 + 1), 0);
+    for (size_t y = 0; y < height; y++) {
+        auto out = raw.data() + y * (width * 4 + 1) + 1;
+        auto px = row(y);
+        for (size_t x = 0; x < width; x++) {
+            auto a = px[4 * x + 3];
+            if (a <= 0)
+                continue;
+            for (size_t c = 0; c < 3; c++)
+                out[4 * x + c] = to_byte(px[4 * x + c] / a);
+            out[4 * x + 3] = to_byte(a);
+        }
+    }
+
+    std::string compressed;
+    if (!zlib_stream(raw, compressed))
+        hypergraph_error("could not compress the image");
+    raw = {};
+
+    std::string out = "\x89PNG\r\n\x1a\n";
+    auto chunk = [&](const char* type, std::string_view data) {
+        put_u32(out, (uint32_t)data.size());
+        auto start = out.size();
+        out.append(type, 4);
+        out.append(data);
+        put_u32(out, crc32_update(0, (const uint8_t*)out.data() + start, out.size() - start));
+    };
+
+    std::string header;
+    put_u32(header, (uint32_t)width);
+    put_u32(header, (uint32_t)height);
+    // 8 bits per channel, RGBA, deflate, adaptive filtering, no interlace
+    header += std::string("\x08\x06\x00\x00\x00", 5);
+
+    chunk("IHDR", header);
+    chunk("IDAT", compressed);
+    chunk("IEND", "");
+
+    return out;
+}
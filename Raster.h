@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Vec2f.h"
+
+// Color with straight, not premultiplied, alpha, every channel in [0, 1]
+struct Rgba {
+    float r = 0;
+    float g = 0;
+    float b = 0;
+    float a = 0;
+};
+
+// Parses a CSS color, "#rgb", "#rrggbb", "rgb(r, g, b)", "rgba(r, g, b, a)", a named color, "none" or "transparent"
+std::optional<Rgba> parse_color(std::string_view str);
+
+// RGBA image with premultiplied float channels, starts out transparent
+struct Image {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<float> pixels;
+
+    Image() = default;
+    Image(size_t width, size_t height) : width(width), height(height), pixels(width * height * 4, 0.0f) {}
+
+    float* row(size_t y) { return pixels.data() + y * width * 4; }
+    const float* row(size_t y) const { return pixels.data() + y * width * 4; }
+
+    // 8 bit RGBA PNG file, compressed with zlib when the build has it and stored uncompressed otherwise
+    std::string encode_png() const;
+
+    // Binary 8 bit RGB PPM file, composited over white since the format has no alpha
+    std::string encode_ppm() const;
+};
+
+// Anti-aliased scanline rasterizer for filled polygons.
+// Every line adds the signed area it covers to an accumulation buffer, a running sum along each row then gives the
+// coverage of every pixel. Overlapping polygons of the same orientation add up, coverage is clamped to 1 which fills
+// with the nonzero rule. The blocks of pixels that lines touch are tracked so a shape costs its outline and the area it
+// fills, not its bounding box.
+class Rasterizer {
+  public:
+    // Starts a new shape clipped to the pixels [x0, x1) x [y0, y1)
+    void begin(long x0, long y0, long x1, long y1);
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+
+    // Adds a polygon edge in pixel coordinates
+    void line(Vec2f a, Vec2f b);
+
+    // Adds a closed polygon
+    void polygon(const Vec2f* points, size_t count);
+
+    // Composites color over image where the shape covers it, opacity multiplies the color's alpha.
+    // Clears the accumulated coverage so the next shape can start right away.
+    void fill(Image& image, Rgba color, float opacity);
+
+  private:
+    long x0 = 0;
+    long y0 = 0;
+    long x1 = 0;
+    long y1 = 0;
+    size_t stride = 0;
+    std::vector<float> accumulation;
+    // One bit per block of pixels in every row that lines were added to
+    std::vector<uint64_t> touched;
+    size_t words_per_row = 0;
+    // Rows lines were added to
+    long first_row = 0;
+    long last_row = -1;
+    std::vector<float> coverage;
+
+    static constexpr size_t block_size = 8;
+
+    void touch(long y, long first, long last);
+    void clipped_line(Vec2f a, Vec2f b);
+};
+
+// Collects path commands in the same form as SvgPath and flattens them into polylines in pixel coordinates
+struct RasterPath {
+    Vec2f offset = {};
+    double scale = 1;
+
+    // Points of all subpaths, subpath i is points[starts[i]..starts[i + 1]]
+    std::vector<Vec2f> points;
+    std::vector<size_t> starts;
+
+    Vec2f current = {};
+
+    void clear() {
+        points.clear();
+        starts.clear();
+    }
+
+    Vec2f to_pixels(Vec2f p) const { return (p - offset) * scale; }
+
+    void move_to(Vec2f p);
+    void line_to(Vec2f p);
+    void arc_to(double rx, double ry, int large_arc, int sweep, Vec2f p);
+
+    // A full circle as its own subpath
+    void circle(Vec2f center, double r);
+
+    size_t subpath_count() const { return starts.size(); }
+    const Vec2f* subpath(size_t i) const { return points.data() + starts[i]; }
+    size_t subpath_size(size_t i) const { return (i + 1 < starts.size() ? starts[i + 1] : points.size()) - starts[i]; }
+
+    // Adds the area inside the subpaths, each closed by a line back to its start
+    void fill(Rasterizer& r) const;
+
+    // Starts a new subpath at a point already in pixel coordinates
+    void add_pixel_subpath(const Vec2f* p, size_t count) {
+        starts.push_back(points.size());
+        points.insert(points.end(), p, p + count);
+    }
+
+    // Replaces out with polygons that together cover the subpaths stroked with round joins and caps, width in
+    // user units. Filling out then draws the stroke.
+    void stroke(RasterPath& out, double width) const;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "Vec2f.h"
+
+// Axis aligned box, min and max are inclusive
+struct Box {
+    Vec2f min = { INFINITY, INFINITY };
+    Vec2f max = { -INFINITY, -INFINITY };
+
+    void add(const Box& b) {
+        min.x = std::min(min.x, b.min.x);
+        min.y = std::min(min.y, b.min.y);
+        max.x = std::max(max.x, b.max.x);
+        max.y = std::max(max.y, b.max.y);
+    }
+
+    bool intersects(const Box& b) const { return min.x <= b.max.x && b.min.x <= max.x && min.y <= b.max.y && b.min.y <= max.y; }
+};
+
+// Static R-tree over boxes for window queries.
+// Packed bottom up with sort-tile-recursive ordering, so every node but the last of a level is full and neighbouring
+// boxes share nodes. Levels are stored one after the other, the children of node i are node_size consecutive entries
+// of the level below.
+struct SpatialIndex {
+    static constexpr size_t node_size = 16;
+    static constexpr size_t max_levels = 16;
+
+    std::vector<Box> nodes;
+    // Id of the box at every leaf
+    std::vector<size_t> ids;
+    // Index in nodes where every level starts, leaves first, and nodes.size() at the end
+    std::vector<size_t> levels;
+
+    void build(const std::vector<Box>& boxes) {
+        nodes.clear();
+        levels.clear();
+        ids.resize(boxes.size());
+        std::iota(ids.begin(), ids.end(), 0);
+
+        if (boxes.empty())
+            return;
+
+        auto center_x = [&](size_t i) { return boxes[i].min.x + boxes[i].max.x; };
+        auto center_y = [&](size_t i) { return boxes[i].min.y + boxes[i].max.y; };
+
+        // Vertical slices of about sqrt(leaf count) leaves each, sorted by y within the slice
+        auto leaf_count = (boxes.size() + node_size - 1) / node_size;
+        auto slice_size = (size_t)std::ceil(std::sqrt((double)leaf_count)) * node_size;
+
+        std::sort(ids.begin(), ids.end(), [&](size_t a, size_t b) { return center_x(a) < center_x(b); });
+        for (size_t s = 0; s < ids.size(); s += slice_size) {
+            auto end = ids.begin() + std::min(ids.size(), s + slice_size);
+            std::sort(ids.begin() + s, end, [&](size_t a, size_t b) { return center_y(a) < center_y(b); });
+        }
+
+        for (auto i : ids)
+            nodes.push_back(boxes[i]);
+        levels.push_back(0);
+
+        while (nodes.size() - levels.back() > 1) {
+            auto begin = levels.back();
+            auto end = nodes.size();
+            levels.push_back(end);
+            for (auto i = begin; i < end; i += node_size) {
+                Box parent;
+                for (auto c = i; c < std::min(end, i + node_size); c++)
+                    parent.add(nodes[c]);
+                nodes.push_back(parent);
+            }
+        }
+        levels.push_back(nodes.size());
+    }
+
+    // Calls f(id) for every box that intersects query, in no particular order
+    template <typename F>
+    void query(const Box& query, F&& f) const {
+        if (nodes.empty())
+            return;
+
+        // Level and index within the level of nodes still to visit
+        struct Entry {
+            size_t level;
+            size_t index;
+        };
+        Entry stack[max_levels * node_size];
+        size_t top = 0;
+        stack[top++] = { levels.size() - 2, 0 };
+
+        while (top > 0) {
+            auto [level, index] = stack[--top];
+            if (!nodes[levels[level] + index].intersects(query))
+                continue;
+
+            if (level == 0) {
+                f(ids[index]);
+                continue;
+            }
+
+            auto child_count = levels[level] - levels[level - 1];
+            for (auto c = index * node_size; c < std::min(child_count, (index + 1) * node_size); c++)
+                stack[top++] = { level - 1, c };
+        }
+    }
+};
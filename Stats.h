@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Wall time per phase and counters of a run, reported by --stats.
+// Phases and counters keep the order they were first recorded in, a phase that runs more than once is summed.
+struct Stats {
+    std::vector<std::pair<std::string, double>> phases;
+    std::vector<std::pair<std::string, uint64_t>> counters;
+    std::vector<std::pair<std::string, double>> values;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    void add_phase(const std::string& name, double seconds) {
+        for (auto& p : phases) {
+            if (p.first == name) {
+                p.second += seconds;
+                return;
+            }
+        }
+        phases.emplace_back(name, seconds);
+    }
+
+    void set(const std::string& name, uint64_t value) {
+        for (auto& c : counters) {
+            if (c.first == name) {
+                c.second = value;
+                return;
+            }
+        }
+        counters.emplace_back(name, value);
+    }
+
+    void set_value(const std::string& name, double value) {
+        for (auto& v : values) {
+            if (v.first == name) {
+                v.second = value;
+                return;
+            }
+        }
+        values.emplace_back(name, value);
+    }
+
+    // Counter or value of name, 0 when it was never recorded
+    uint64_t counter(const std::string& name) const {
+        for (auto& c : counters) {
+            if (c.first == name)
+                return c.second;
+        }
+        return 0;
+    }
+
+    double value(const std::string& name) const {
+        for (auto& v : values) {
+            if (v.first == name)
+                return v.second;
+        }
+        return 0;
+    }
+
+    // Peak resident set size of the process in bytes
+    static uint64_t peak_rss() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+    }
+
+    double total_seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+    nlohmann::json to_json() const {
+        auto res = nlohmann::json::object();
+        res["total-seconds"] = total_seconds();
+        res["peak-rss-bytes"] = peak_rss();
+
+        auto& phase_json = res["phases"] = nlohmann::json::array();
+        for (auto& [name, seconds] : phases)
+            phase_json.push_back({ { "name", name }, { "seconds", seconds } });
+
+        for (auto& [name, value] : counters)
+            res[name] = value;
+        for (auto& [name, value] : values)
+            res[name] = value;
+        return res;
+    }
+
+    // Records the size of g as counters
+    template <typename Hypergraph>
+    void count(const Hypergraph& g) {
+        set("vertices", g.vertices.size());
+        set("edges", g.edges.size());
+        set("incidences", g.incidence_count());
+        set("largest-edge", g.largest_edge());
+    }
+
+    bool write_json(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        auto text = to_json().dump() + "\n";
+        bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    void print(FILE* file) const {
+        for (auto& [name, seconds] : phases)
+            fprintf(file, "%-20s %10.3f ms\n", name.c_str(), seconds * 1000);
+        fprintf(file, "%-20s %10.3f ms\n", "total", total_seconds() * 1000);
+        for (auto& [name, value] : counters)
+            fprintf(file, "%-20s %10llu\n", name.c_str(), (unsigned long long)value);
+        for (auto& [name, value] : values)
+            fprintf(file, "%-20s %10.4g\n", name.c_str(), value);
+        fprintf(file, "%-20s %10.1f MiB\n", "peak-rss", peak_rss() / (1024.0 * 1024.0));
+    }
+};
+
+// Adds the time until it is destroyed to a phase of stats, does nothing when stats is null
+class StatsTimer {
+  public:
+    StatsTimer(Stats* stats, const char* name) : stats(stats), name(name), start(std::chrono::steady_clock::now()) {}
+
+    ~StatsTimer() {
+        if (stats)
+            stats->add_phase(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+  private:
+    Stats* stats;
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
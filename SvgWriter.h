@@ -0,0 +1,100 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <string_view>
+
+#include "Vec2f.h"
+
+// Marks a number as a coordinate so it is rounded to the writer's precision
+struct Coord {
+    double value;
+};
+
+// Appends SVG markup to a string.
+// Numbers are written in their shortest round trip form with std::to_chars, so 12 is written as 12 and not 12.000000.
+// Coordinates are first rounded to a fixed number of decimals.
+struct SvgWriter {
+    std::string& out;
+    int precision;
+    double scale;
+
+    SvgWriter(std::string& out, int precision = 6) : out(out), precision(precision), scale(std::pow(10.0, precision)) {}
+
+    double quantize(double v) const {
+        auto q = std::round(v * scale) / scale;
+        // Avoid writing -0
+        return q == 0 ? 0 : q;
+    }
+
+    SvgWriter& operator<<(std::string_view str) {
+        out.append(str);
+        return *this;
+    }
+
+    SvgWriter& operator<<(double v) {
+        char buf[32];
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+        return *this;
+    }
+
+    SvgWriter& operator<<(int v) {
+        char buf[16];
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+        return *this;
+    }
+
+    SvgWriter& operator<<(Coord c) { return *this << quantize(c.value); }
+};
+
+// Writes the data of a path element without separators between commands.
+// Every command is written relative to the current point when that comes out shorter. The current point is kept
+// quantized the same way the absolute coordinates are, so relative commands do not accumulate rounding errors.
+struct SvgPath {
+    SvgWriter& w;
+    Vec2f current = {};
+
+    void move_to(Vec2f p) { command("M", "m", "", p); }
+
+    void line_to(Vec2f p) { command("L", "l", "", p); }
+
+    void arc_to(double rx, double ry, int large_arc, int sweep, Vec2f p) {
+        char args[80];
+        auto end = args;
+        end = std::to_chars(end, args + sizeof(args), rx).ptr;
+        *end++ = ' ';
+        end = std::to_chars(end, args + sizeof(args), ry).ptr;
+        *end++ = ' ';
+        *end++ = '0';
+        *end++ = ' ';
+        *end++ = large_arc ? '1' : '0';
+        *end++ = ' ';
+        *end++ = sweep ? '1' : '0';
+        *end++ = ' ';
+        command("A", "a", std::string_view(args, end - args), p);
+    }
+
+  private:
+    void command(std::string_view absolute, std::string_view relative, std::string_view args, Vec2f p) {
+        Vec2f q = { w.quantize(p.x), w.quantize(p.y) };
+
+        char abs_buf[64];
+        char rel_buf[64];
+        auto abs_end = point(abs_buf, q);
+        auto rel_end = point(rel_buf, Vec2f{ w.quantize(q.x - current.x), w.quantize(q.y - current.y) });
+
+        if (rel_end - rel_buf < abs_end - abs_buf)
+            w << relative << args << std::string_view(rel_buf, rel_end - rel_buf);
+        else
+            w << absolute << args << std::string_view(abs_buf, abs_end - abs_buf);
+
+        current = q;
+    }
+
+    static char* point(char* buf, Vec2f p) {
+        auto end = std::to_chars(buf, buf + 31, p.x).ptr;
+        *end++ = ' ';
+        return std::to_chars(end, buf + 63, p.y).ptr;
+    }
+};
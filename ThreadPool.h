@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed size pool of threads for data parallel loops.
+// A loop is cut into chunks that are dealt out to per thread queues, a thread that runs out of work steals
+// chunks from the front of the other queues. The calling thread works on the loop as well.
+class ThreadPool {
+  public:
+    explicit ThreadPool(size_t thread_count) {
+        thread_count = std::max<size_t>(thread_count, 1);
+
+        for (size_t i = 0; i < thread_count; i++)
+            queues.push_back(std::make_unique<Queue>());
+
+        for (size_t i = 1; i < thread_count; i++)
+            workers.emplace_back([this, i]() { worker_main(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t thread_count() const { return queues.size(); }
+
+    // Calls f(begin, end) on chunks of at most grain indexes covering [0, count) and returns once all have finished.
+    // Chunks may run in any order and on any thread so f must only write to state owned by its range.
+    template <typename F>
+    void parallel_for(size_t count, size_t grain, F&& f) {
+        if (count == 0)
+            return;
+
+        grain = std::max<size_t>(grain, 1);
+
+        if (queues.size() == 1 || count <= grain) {
+            f((size_t)0, count);
+            return;
+        }
+
+        Job fn = [&](size_t begin, size_t end) { f(begin, end); };
+        run(count, grain, fn);
+    }
+
+  private:
+    using Job = std::function<void(size_t, size_t)>;
+    using Range = std::pair<size_t, size_t>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    size_t generation = 0;
+    bool stopping = false;
+
+    std::atomic<const Job*> job = nullptr;
+    std::atomic<size_t> remaining = 0;
+
+    void run(size_t count, size_t grain, const Job& fn) {
+        auto chunks = (count + grain - 1) / grain;
+
+        // The job is published before any of its ranges so a thread that pops a range always sees the matching job
+        job = &fn;
+        remaining = chunks;
+
+        for (size_t c = 0; c < chunks; c++) {
+            auto& q = *queues[c * queues.size() / chunks];
+            std::lock_guard lock(q.mutex);
+            q.ranges.emplace_back(c * grain, std::min(count, (c + 1) * grain));
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            generation++;
+        }
+        wake.notify_all();
+
+        work(0);
+
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [&]() { return remaining == 0; });
+        job = nullptr;
+    }
+
+    bool pop(size_t self, Range& range) {
+        {
+            auto& q = *queues[self];
+            std::lock_guard lock(q.mutex);
+            if (!q.ranges.empty()) {
+                range = q.ranges.back();
+                q.ranges.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < queues.size(); i++) {
+            auto& q = *queues[(self + i) % queues.size()];
+            std::lock_guard lock(q.mutex);
+            if (!q.ranges.empty()) {
+                range = q.ranges.front();
+                q.ranges.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void work(size_t self) {
+        Range range;
+        while (pop(self, range)) {
+            (*job.load())(range.first, range.second);
+
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+
+    void worker_main(size_t self) {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            work(self);
+        }
+    }
+};
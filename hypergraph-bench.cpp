@@ -0,0 +1,183 @@
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "CommandLine.h"
+#include "Draw.h"
+#include "Generator.h"
+#include "Hypergraph.h"
+#include "Layout.h"
+#include "ThreadPool.h"
+
+// Times every stage of the pipeline on generated hypergraphs of growing size.
+// Prints one json object per line and stage with the fastest and the median of the repeated runs in seconds.
+
+struct BenchOptions {
+    size_t min_vertices = 10;
+    size_t max_vertices = 1000000;
+    size_t repeat = 3;
+    uint64_t seed = 0;
+    size_t layout_iterations = 50;
+    // Graphviz engines are far too slow for the biggest sizes
+    size_t graphviz_max_vertices = 10000;
+    // Generated positions are random so every hyperedge spans the whole image
+    size_t raster_max_vertices = 100000;
+    size_t threads = 0;
+};
+
+int main(int argc, char** argv) {
+
+    BenchOptions options;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            std::string value;
+
+            auto eq = arg.find('=');
+            if (eq != std::string::npos) {
+                value = arg.substr(eq + 1);
+                arg = arg.substr(0, eq);
+            } else if (i + 1 < argc) {
+                value = argv[++i];
+            } else {
+                hypergraph_error("missing value for %s", arg.c_str());
+            }
+
+            if (arg == "--min-vertices")
+                options.min_vertices = parse_count_flag(arg, value);
+            else if (arg == "--max-vertices")
+                options.max_vertices = parse_count_flag(arg, value);
+            else if (arg == "--repeat")
+                options.repeat = std::max<size_t>(parse_count_flag(arg, value), 1);
+            else if (arg == "--seed")
+                options.seed = parse_count_flag(arg, value);
+            else if (arg == "--layout-iterations")
+                options.layout_iterations = parse_count_flag(arg, value);
+            else if (arg == "--graphviz-max-vertices")
+                options.graphviz_max_vertices = parse_count_flag(arg, value);
+            else if (arg == "--raster-max-vertices")
+                options.raster_max_vertices = parse_count_flag(arg, value);
+            else if (arg == "--threads")
+                options.threads = parse_count_flag(arg, value);
+            else
+                hypergraph_error("unknown option %s", arg.c_str());
+        }
+
+        if (options.min_vertices == 0)
+            hypergraph_error("--min-vertices must be positive");
+
+        ThreadPool pool(options.threads ? options.threads : std::thread::hardware_concurrency());
+
+        for (size_t n = options.min_vertices; n <= options.max_vertices; n *= 10) {
+            GeneratorOptions gen;
+            gen.vertex_count = n;
+            gen.edge_count = n;
+            gen.seed = options.seed;
+            gen.size_distribution = EdgeSizeDistribution::POWER_LAW;
+            gen.max_edge_size = 32;
+            gen.communities = std::max<size_t>(n / 100, 1);
+            gen.positions = true;
+
+            Hypergraph g;
+            size_t incidences = 0;
+
+            auto report = [&](const char* stage, std::vector<double> times, nlohmann::json extra = nlohmann::json::object()) {
+                std::sort(times.begin(), times.end());
+                extra["stage"] = stage;
+                extra["vertices"] = n;
+                extra["edges"] = g.edges.size();
+                extra["incidences"] = incidences;
+                extra["threads"] = pool.thread_count();
+                extra["min-seconds"] = times.front();
+                extra["median-seconds"] = times[times.size() / 2];
+                std::cout << extra << std::endl;
+            };
+
+            auto time = [&](auto&& f) {
+                std::vector<double> times;
+                for (size_t r = 0; r < options.repeat; r++) {
+                    auto start = std::chrono::steady_clock::now();
+                    f();
+                    times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                }
+                return times;
+            };
+
+            // Fields of the report are read after the timed runs, function arguments have no evaluation order
+            auto times = time([&]() { g = generate_hypergraph(gen); });
+            for (auto& e : g.edges)
+                incidences += e.vertices.size();
+            report("generate", times);
+
+            std::string text;
+            times = time([&]() { text = hypergraph_to_json(g).dump(); });
+            report("json-write", times, { { "bytes", text.size() } });
+
+            report("json-parse", time([&]() {
+                       auto file = fmemopen(text.data(), text.size(), "r");
+                       read_json_hypergraph(file, true);
+                       fclose(file);
+                   }));
+            text = {};
+
+            size_t expansion_edges = 0;
+            times = time([&]() { expansion_edges = expand_hypergraph(g, LayoutOptions{}).edges.size(); });
+            report("clique-expansion", times, { { "graph-edges", expansion_edges } });
+
+            LayoutOptions layout;
+            layout.force.iterations = options.layout_iterations;
+            layout.engine = "native-fdp";
+            report("layout-native-fdp", time([&]() { layout_hypergraph(g, layout, &pool); }), { { "iterations", options.layout_iterations } });
+
+            layout.engine = "pivot-mds";
+            report("layout-pivot-mds", time([&]() { layout_hypergraph(g, layout, &pool); }), { { "pivots", layout.pivots } });
+
+#ifdef HAVE_GRAPHVIZ
+            // Includes the clique expansion and building the graphviz graph
+            if (n <= options.graphviz_max_vertices) {
+                layout.engine = "neato";
+                report("layout-neato", time([&]() { layout_hypergraph(g, layout); }));
+            }
+#endif
+
+            report("outline", time([&]() {
+                       for (auto& e : g.edges)
+                           edge_outline(g, e, false);
+                   }));
+
+            report("outline-hull", time([&]() {
+                       for (auto& e : g.edges)
+                           edge_outline(g, e, true);
+                   }));
+
+            size_t svg_bytes = 0;
+            times = time([&]() {
+                svg_bytes = 0;
+                draw_svg(g, DrawOptions{}, [&](std::string_view str) { svg_bytes += str.size(); }, &pool);
+            });
+            report("svg", times, { { "bytes", svg_bytes } });
+
+            size_t html_bytes = 0;
+            times = time([&]() {
+                html_bytes = 0;
+                draw_html(g, DrawOptions{}, [&](std::string_view str) { html_bytes += str.size(); }, &pool);
+            });
+            report("html", times, { { "bytes", html_bytes } });
+
+            if (n <= options.raster_max_vertices)
+                report("raster", time([&]() { draw_raster(g, DrawOptions{}, &pool); }), { { "width", DrawOptions{}.raster_width } });
+        }
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "CommandLine.h"
+#include "Generator.h"
+#include "Hypergraph.h"
+
+int main(int argc, char** argv) {
+
+    GeneratorOptions options;
+    bool edges_set = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            std::string value;
+
+            // Options are given as --name value or --name=value
+            auto eq = arg.find('=');
+            if (eq != std::string::npos) {
+                value = arg.substr(eq + 1);
+                arg = arg.substr(0, eq);
+            } else if (arg == "--positions") {
+                options.positions = true;
+                continue;
+            } else if (i + 1 < argc) {
+                value = argv[++i];
+            } else {
+                hypergraph_error("missing value for %s", arg.c_str());
+            }
+
+            if (arg == "--vertices") {
+                options.vertex_count = parse_count_flag(arg, value);
+            } else if (arg == "--edges") {
+                options.edge_count = parse_count_flag(arg, value);
+                edges_set = true;
+            } else if (arg == "--seed") {
+                options.seed = parse_count_flag(arg, value);
+            } else if (arg == "--size-distribution") {
+                options.size_distribution = GeneratorOptions::parse_distribution(value);
+            } else if (arg == "--min-edge-size") {
+                options.min_edge_size = parse_count_flag(arg, value);
+            } else if (arg == "--max-edge-size") {
+                options.max_edge_size = parse_count_flag(arg, value);
+            } else if (arg == "--exponent") {
+                options.exponent = parse_number_flag(arg, value);
+            } else if (arg == "--communities") {
+                options.communities = parse_count_flag(arg, value);
+            } else if (arg == "--mixing") {
+                options.mixing = parse_number_flag(arg, value);
+            } else {
+                hypergraph_error("unknown option %s", arg.c_str());
+            }
+        }
+
+        if (!edges_set)
+            options.edge_count = options.vertex_count;
+
+        std::cout << hypergraph_to_json(generate_hypergraph(options));
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+}
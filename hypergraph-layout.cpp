@@ -1,166 +1,249 @@
-#include <float.h>
 #include <stdio.h>
 
-#include <fstream>
-#include <functional>
-#include <iostream>
-#include <type_traits>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
 
-#include <gvc.h>
 #include <nlohmann/json.hpp>
 
-#include "Vec2f.h"
-
-#define JSON_ERR(msg, ...)                                                                                                                                                                                                 \
-    do {                                                                                                                                                                                                                   \
-        fprintf(stderr, msg "\n" __VA_OPT__(, ) __VA_ARGS__);                                                                                                                                                              \
-        exit(1);                                                                                                                                                                                                           \
-    } while (false);
-
-struct Vertex {
-    size_t index;
-    Agnode_t* node;
-    nlohmann::json json;
-};
+#include "Batch.h"
+#include "BinaryFormat.h"
+#include "CommandLine.h"
+#include "Hypergraph.h"
+#include "Layout.h"
+#include "Stats.h"
+#include "SvgWriter.h"
+#include "ThreadPool.h"
+
+// Writes positions as one line of json, {"frame":frame,"positions":[x0,y0,x1,y1,...]} rounded to 2 decimals
+static void write_frame(FILE* out, size_t frame, const std::vector<Vec2f>& positions) {
+    std::string text;
+    SvgWriter w(text, 2);
+    w << "{\"frame\":" << (int)frame << ",\"positions\":[";
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (i > 0)
+            w << ",";
+        w << Coord{ positions[i].x } << "," << Coord{ positions[i].y };
+    }
+    w << "]}\n";
+    fwrite(text.data(), 1, text.size(), out);
+    fflush(out);
+}
 
-struct Hyperedge {
-    std::vector<size_t> vertices;
-};
+// Tells on stderr how far a layout got when its time budget ran out, stats has to come from layout_hypergraph
+static void report_out_of_time(const Stats& stats) {
+    if (stats.counter("out-of-time"))
+        fprintf(stderr, "layout stopped by the time budget after %llu iterations, energy %g\n", (unsigned long long)stats.counter("layout-iterations"), stats.value("layout-energy"));
+}
 
 int main(int argc, char** argv) {
 
-    nlohmann::json json;
-
-    if (argc > 1) {
-        auto file = std::ifstream(argv[1]);
-        if (!file) {
-            fprintf(stderr, "Could not open file '%s'\n", argv[1]);
-            return 0;
-        }
-        file >> json;
-    } else {
-        std::cin >> json;
-    }
-
-    if (!json.contains("edges") || !json["edges"].is_array())
-        JSON_ERR("missing edges field");
-
-    std::vector<Vertex> vertices;
-    std::vector<Hyperedge> edges;
-
-    if (json.contains("vertices")) {
-        if (json["vertices"].is_array()) {
-            size_t index = 0;
-            auto verts_json = json["vertices"];
-            for (auto v : verts_json) {
-                Vertex res;
-                res.index = index++;
-                res.json = v;
-                vertices.push_back(res);
+    const char* input_path = nullptr;
+    size_t thread_count = 0;
+    double time_budget_ms = 0;
+    size_t frame_iterations = 0;
+    double frame_ms = 0;
+    bool binary_output = false;
+    bool incremental = false;
+    bool batch = false;
+    std::string socket_path;
+    size_t worker_count = 1;
+    std::string cache_dir;
+    bool print_stats = false;
+    std::string stats_path;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                thread_count = parse_count_flag(arg, argv[++i]);
+            } else if (arg.starts_with("--threads=")) {
+                thread_count = parse_count_flag("--threads", arg.substr(10));
+            } else if (arg == "--time-budget-ms" && i + 1 < argc) {
+                time_budget_ms = parse_number_flag(arg, argv[++i]);
+            } else if (arg.starts_with("--time-budget-ms=")) {
+                time_budget_ms = parse_number_flag("--time-budget-ms", arg.substr(17));
+            } else if (arg == "--frames" && i + 1 < argc) {
+                frame_iterations = parse_count_flag(arg, argv[++i]);
+            } else if (arg.starts_with("--frames=")) {
+                frame_iterations = parse_count_flag("--frames", arg.substr(9));
+            } else if (arg == "--frame-ms" && i + 1 < argc) {
+                frame_ms = parse_number_flag(arg, argv[++i]);
+            } else if (arg.starts_with("--frame-ms=")) {
+                frame_ms = parse_number_flag("--frame-ms", arg.substr(11));
+            } else if (arg == "--binary") {
+                binary_output = true;
+            } else if (arg == "--incremental") {
+                incremental = true;
+            } else if (arg == "--cache" && i + 1 < argc) {
+                cache_dir = argv[++i];
+            } else if (arg.starts_with("--cache=")) {
+                cache_dir = arg.substr(8);
+            } else if (arg == "--batch") {
+                batch = true;
+            } else if (arg == "--socket" && i + 1 < argc) {
+                socket_path = argv[++i];
+            } else if (arg.starts_with("--socket=")) {
+                socket_path = arg.substr(9);
+            } else if (arg == "--workers" && i + 1 < argc) {
+                worker_count = parse_count_flag(arg, argv[++i]);
+            } else if (arg.starts_with("--workers=")) {
+                worker_count = parse_count_flag("--workers", arg.substr(10));
+            } else if (arg == "--stats") {
+                print_stats = true;
+            } else if (arg == "--stats-json" && i + 1 < argc) {
+                stats_path = argv[++i];
+            } else if (arg.starts_with("--stats-json=")) {
+                stats_path = arg.substr(13);
+            } else {
+                input_path = argv[i];
             }
-        } else if (json["vertices"].is_object()) {
-
-            for (auto& p : json["vertices"].items()) {
-                auto index = [&]() {
-                    try {
-                        return std::stoi(p.key());
-                    } catch (...) {
-                        JSON_ERR("keys in vertices object must be indexes")
-                    }
-                }();
-
-                while (vertices.size() < index + 1) {
-                    vertices.push_back({ .index = vertices.size() - 1 });
-                }
-
-                vertices[index].json = p.value();
-            }
-
-        } else {
-            JSON_ERR("invalid vertices field");
         }
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
     }
 
-    {
-        size_t max_vert_index = 0;
-
-        auto edges_json = json["edges"];
-        for (auto e : edges_json) {
-            if (!e.contains("vertices"))
-                JSON_ERR("edge missing list of vertices");
-
-            auto verts_json = e["vertices"];
-            if (!verts_json.is_array())
-                JSON_ERR("edge[].vertices must be an array");
-
-            Hyperedge res;
-
-            for (auto v : verts_json) {
-                if (!v.is_number_unsigned())
-                    JSON_ERR("edge[].vertices[] must be an index into the list of vertices");
-                auto v_index = v.get<size_t>();
-                if (v_index < 0)
-                    JSON_ERR("edge[].vertices[] must be an index into the list of vertices");
-                max_vert_index = std::max(max_vert_index, v_index);
-                res.vertices.push_back(v_index);
-            }
-
-            edges.push_back(res);
-        }
-
-        while (vertices.size() < max_vert_index + 1) {
-            vertices.push_back({ .index = vertices.size() - 1 });
-        }
+    if ((batch || !socket_path.empty()) && (binary_output || print_stats || !stats_path.empty())) {
+        fprintf(stderr, "--batch and --socket can not be combined with --binary or --stats\n");
+        return 1;
     }
 
-    auto gvc = gvContext();
-
-    Agraph_t* g = agopen(0, Agundirected, 0);
-
-    for (auto& v : vertices) {
-        v.node = agnode(g, 0, 1);
+    bool frames = frame_iterations > 0 || frame_ms > 0;
+    if (frames && (batch || !socket_path.empty() || binary_output)) {
+        fprintf(stderr, "--frames and --frame-ms can not be combined with --batch, --socket or --binary\n");
+        return 1;
     }
 
-    for (auto e : edges) {
-        // Create a complete graph with the edges
-
-        auto rec = [&](auto rec, std::vector<size_t> remaining_verts) {
-            if (remaining_verts.size() <= 1)
-                return;
-
-            auto back = remaining_verts.back();
-            remaining_verts.pop_back();
-
-            for (auto v : remaining_verts)
-                agedge(g, vertices[back].node, vertices[v].node, 0, 1);
+    FILE* file = stdin;
+    if (input_path) {
+        file = fopen(input_path, "rb");
+        if (!file) {
+            fprintf(stderr, "Could not open file '%s'\n", input_path);
+            return 0;
+        }
+    }
 
-            rec(rec, remaining_verts);
+    if (batch || !socket_path.empty()) {
+        // Unless --threads says otherwise the cores are split between the workers
+        auto threads_per_worker = thread_count ? thread_count : std::max<size_t>(1, std::thread::hardware_concurrency() / std::max<size_t>(worker_count, 1));
+
+        auto process = [&](const std::string& line) {
+            // Every worker keeps one pool for all documents it lays out
+            thread_local std::unique_ptr<ThreadPool> pool;
+            if (!pool)
+                pool = std::make_unique<ThreadPool>(threads_per_worker);
+
+            auto g = read_json_hypergraph(line, false);
+            auto options = LayoutOptions::from_json(g.options);
+            if (incremental)
+                options.incremental = true;
+            if (time_budget_ms > 0)
+                options.time_budget_ms = time_budget_ms;
+            options.cache_dir = cache_dir;
+
+            Stats stats;
+            auto positions = layout_hypergraph(g, options, pool.get(), options.time_budget_ms > 0 ? &stats : nullptr);
+            report_out_of_time(stats);
+            g.set_positions(positions);
+            std::string res;
+            write_json_hypergraph(g, [&](std::string_view str) { res.append(str); });
+            return res;
         };
 
-        rec(rec, e.vertices);
+        try {
+            if (!socket_path.empty())
+                serve_batch(socket_path, worker_count, process);
+            else
+                run_batch(file, stdout, worker_count, process);
+        } catch (const std::exception& ex) {
+            fprintf(stderr, "%s\n", ex.what());
+            return 1;
+        }
+        return 0;
     }
 
-    std::string layout = "neato";
-    if (json.contains("layout-engine") && json["layout-engine"].is_string())
-        layout = json["layout-engine"];
-
-    gvLayout(gvc, g, layout.c_str());
+    try {
+        // Nothing is measured unless asked for
+        Stats stats;
+        Stats* stats_ptr = print_stats || !stats_path.empty() ? &stats : nullptr;
+
+        Hypergraph g;
+        std::optional<StatsTimer> timer;
+        timer.emplace(stats_ptr, "read");
+
+        MappedFile binary_file;
+        BinaryHypergraph binary;
+        if (is_binary_input(file)) {
+            if (!binary_file.open(file))
+                hypergraph_error("could not read input");
+            if (auto error = binary.load(binary_file.data(), binary_file.size()))
+                hypergraph_error("%s", error);
+            g = hypergraph_from_binary(binary);
+        } else {
+            // Attributes the library does not draw are kept in the hypergraph and written out again
+            g = read_json_hypergraph(file, false);
+        }
+        timer.reset();
+
+        auto options = LayoutOptions::from_json(g.options);
+
+        // The command line takes precedence over the json
+        if (thread_count != 0)
+            options.threads = thread_count;
+        if (incremental)
+            options.incremental = true;
+        if (time_budget_ms > 0)
+            options.time_budget_ms = time_budget_ms;
+        options.cache_dir = cache_dir;
+
+        // The layout counters are needed to report a layout that ran out of time
+        if (options.time_budget_ms > 0)
+            stats_ptr = &stats;
+
+        // Frames go to stdout ahead of the finished document
+        size_t frame_count = 0;
+        if (frames) {
+            options.frame_iterations = frame_iterations;
+            options.frame_ms = frame_ms;
+            options.on_frame = [&](const std::vector<Vec2f>& positions) { write_frame(stdout, frame_count++, positions); };
+        }
 
-    gvRender(gvc, g, "dot", 0);
+        auto positions = layout_hypergraph(g, options, nullptr, stats_ptr);
+        report_out_of_time(stats);
 
-    nlohmann::json verts_json = {};
+        g.set_positions(positions);
 
-    auto pos_str = strdup("pos");
+        size_t bytes_written = 0;
+        timer.emplace(stats_ptr, "write");
 
-    for (auto i = 0; i < vertices.size(); i++) {
-        auto pos_string = std::string(agget(vertices[i].node, pos_str));
-        double x = std::stof(pos_string.substr(0, pos_string.find_first_of(",")));
-        double y = std::stof(pos_string.substr(pos_string.find_first_of(",") + 1));
-        vertices[i].json["pos"] = nlohmann::json::array({ x, y });
-        verts_json.push_back(vertices[i].json);
+        if (binary_output) {
+            auto writer = hypergraph_to_binary(g);
+            if (!writer.write(stdout))
+                hypergraph_error("could not write output");
+            bytes_written = writer.file_size();
+        } else {
+            write_json_hypergraph(g, [&](std::string_view str) {
+                fwrite(str.data(), 1, str.size(), stdout);
+                bytes_written += str.size();
+            });
+        }
+        timer.reset();
+
+        if (print_stats || !stats_path.empty()) {
+            fflush(stdout);
+            stats.count(g);
+            stats.set("bytes-written", bytes_written);
+            if (print_stats)
+                stats.print(stderr);
+            if (!stats_path.empty() && !stats.write_json(stats_path))
+                hypergraph_error("could not write stats to '%s'", stats_path.c_str());
+        }
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
     }
-
-    json["vertices"] = verts_json;
-
-    std::cout << json;
 }
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "BinaryFormat.h"
+#include "Check.h"
+#include "Hypergraph.h"
+
+// Bytes of the binary form of g
+static std::string binary_bytes(const Hypergraph& g) {
+    FILE* file = tmpfile();
+    CHECK(file);
+    CHECK(hypergraph_to_binary(g).write(file));
+
+    std::string res(ftell(file), '\0');
+    rewind(file);
+    CHECK(fread(res.data(), 1, res.size(), file) == res.size());
+    fclose(file);
+    return res;
+}
+
+// Loads bytes, which are copied to 8 byte aligned storage first as a mapped file would be, and returns the error
+static const char* load_error(const std::string& bytes) {
+    std::vector<uint64_t> storage((bytes.size() + 7) / 8);
+    memcpy(storage.data(), bytes.data(), bytes.size());
+    BinaryHypergraph binary;
+    return binary.load((const char*)storage.data(), bytes.size());
+}
+
+static Hypergraph load(const std::string& bytes, std::vector<uint64_t>& storage) {
+    storage.assign((bytes.size() + 7) / 8, 0);
+    memcpy(storage.data(), bytes.data(), bytes.size());
+    BinaryHypergraph binary;
+    CHECK(binary.load((const char*)storage.data(), bytes.size()) == nullptr);
+    return hypergraph_from_binary(binary);
+}
+
+// Overwrites the uint64 at byte offset with value
+static std::string patched(std::string bytes, size_t offset, uint64_t value) {
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+    return bytes;
+}
+
+int main() {
+    const char* text = R"({
+        "layout-iterations": 0, "coordinate-precision": 1, "layout-seed": 18446744073709551557, "offset": -7,
+        "layout-theta": 0.75, "vertex-fill": "red", "edge-convex-hull": true,
+        "vertices": [{"pos": [0, 0.5], "radius": 3, "fill": "blue", "weight": -2}, {"pos": [10, 10], "label": "b", "rank": 2.5}, {"pos": [5, 20]}],
+        "edges": [{"vertices": [0, 1, 2], "stroke-width": 1.5, "id": 12}, {"vertices": [2]}]
+    })";
+
+    auto g = read_json_hypergraph(std::string_view(text), true);
+    auto bytes = binary_bytes(g);
+
+    // Json to binary to json keeps every scalar with its type
+    std::vector<uint64_t> storage;
+    auto loaded = load(bytes, storage);
+    CHECK(loaded.options == g.options);
+    CHECK(loaded.options["layout-iterations"].is_number_unsigned());
+    CHECK(loaded.options["layout-seed"].get<uint64_t>() == 18446744073709551557ull);
+    CHECK(loaded.options["offset"].get<int64_t>() == -7);
+    CHECK(hypergraph_to_json(loaded) == hypergraph_to_json(g));
+
+    // Malformed files are rejected instead of read
+    CHECK(load_error(bytes) == nullptr);
+    CHECK(load_error(std::string(bytes).replace(0, 1, "X")) != nullptr);
+    CHECK(load_error(patched(bytes, offsetof(BinaryHeader, version), 99)) != nullptr);
+
+    // Only the padding after the string table can be cut off
+    auto strings_size = ((const BinaryHeader*)bytes.data())->string_table_size;
+    for (size_t size = 0; size < bytes.size() - (8 - strings_size % 8) % 8; size++)
+        CHECK(load_error(bytes.substr(0, size)) != nullptr);
+
+    // Counts that run past the end of the file
+    CHECK(load_error(patched(bytes, offsetof(BinaryHeader, edge_count), 1ull << 60)) != nullptr);
+    CHECK(load_error(patched(bytes, offsetof(BinaryHeader, incidence_count), 1ull << 60)) != nullptr);
+    CHECK(load_error(patched(bytes, offsetof(BinaryHeader, attribute_count), ~0ull)) != nullptr);
+
+    // Edge offsets that are out of range or decreasing, and vertex indexes past the vertices
+    auto offsets = sizeof(BinaryHeader);
+    CHECK(load_error(patched(bytes, offsets, 1)) != nullptr);
+    CHECK(load_error(patched(bytes, offsets + 8, 5)) != nullptr);
+    CHECK(load_error(patched(bytes, offsets + 16, 2)) != nullptr);
+    auto incidences = offsets + 3 * sizeof(uint64_t);
+    CHECK(load_error(patched(bytes, incidences, 3)) != nullptr);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Hypergraph.h"
+#include "Layout.h"
+#include "LayoutCache.h"
+#include "Stats.h"
+
+int main() {
+    char dir_template[] = "/tmp/layout-cache-XXXXXX";
+    CHECK(mkdtemp(dir_template));
+    std::string dir = dir_template;
+
+    // Entries read back bit for bit, and only for the vertex count they were stored with
+    std::vector<Vec2f> positions = { { 0.1, -2.5e300 }, { 1.0 / 3.0, 7 }, { -0.0, 4e-310 } };
+    CHECK(write_cached_layout(dir, "entry", positions));
+    auto cached = read_cached_layout(dir, "entry", positions.size());
+    CHECK(cached && cached->size() == positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+        CHECK(memcmp(&(*cached)[i], &positions[i], sizeof(Vec2f)) == 0);
+    CHECK(!read_cached_layout(dir, "entry", positions.size() + 1));
+    CHECK(!read_cached_layout(dir, "missing", positions.size()));
+
+    // A layout that hits the cache returns exactly the positions of the run that stored them
+    Hypergraph g;
+    g.vertices.resize(20);
+    for (size_t v = 0; v + 2 < g.vertices.size(); v++)
+        g.edges.push_back({ .vertices = { v, v + 1, v + 2 } });
+
+    LayoutOptions options;
+    options.engine = "native-fdp";
+    options.cache_dir = dir;
+
+    Stats miss, hit;
+    auto computed = layout_hypergraph(g, options, nullptr, &miss);
+    auto reused = layout_hypergraph(g, options, nullptr, &hit);
+    CHECK(miss.counter("cache-hit") == 0 && hit.counter("cache-hit") == 1);
+    CHECK(reused.size() == computed.size());
+    for (size_t i = 0; i < computed.size(); i++)
+        CHECK(reused[i].x == computed[i].x && reused[i].y == computed[i].y);
+
+    // A cache that can not be written to leaves the layout working
+    options.cache_dir = dir + "/entry.layout/below-a-file";
+    Stats failed;
+    CHECK(!write_cached_layout(options.cache_dir, "entry", positions));
+    CHECK(layout_hypergraph(g, options, nullptr, &failed).size() == g.vertices.size());
+    CHECK(failed.counter("cache-write-failed") == 1);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}